@@ -5,8 +5,16 @@
 #include <boost/asio/steady_timer.hpp>
 #include <sdbusplus/exception.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <vector>
+
+// The endpoints property, as D-Bus has it
+static std::vector<std::string> endpointsProperty(const Endpoints& endpoints)
+{
+    return {endpoints.begin(), endpoints.end()};
+}
 
 static void updateEndpointsOnDbus(sdbusplus::asio::object_server& objectServer,
                                   const std::string& assocPath,
@@ -32,13 +40,13 @@ static void updateEndpointsOnDbus(sdbusplus::asio::object_server& objectServer,
         }
         else
         {
-            i->set_property("endpoints", endpoints);
+            i->set_property("endpoints", endpointsProperty(endpoints));
         }
     }
     else if (!endpoints.empty())
     {
         i = objectServer.add_interface(assocPath, xyzAssociationInterface);
-        i->register_property("endpoints", endpoints);
+        i->register_property("endpoints", endpointsProperty(endpoints));
         i->initialize();
     }
 
@@ -135,8 +143,7 @@ void removeAssociation(boost::asio::io_context& io,
 
 void removeAssociationEndpoints(
     boost::asio::io_context& io, sdbusplus::asio::object_server& objectServer,
-    const std::string& assocPath,
-    const boost::container::flat_set<std::string>& endpointsToRemove,
+    const std::string& assocPath, const EndpointSet& endpointsToRemove,
     AssociationMaps& assocMaps)
 {
     auto assoc = assocMaps.ifaces.find(assocPath);
@@ -157,6 +164,7 @@ void removeAssociationEndpoints(
             endpointsInDBus.erase(e);
         }
     }
+    std::get<endpointLookupPos>(assoc->second).clear();
 
     scheduleUpdateEndpointsOnDbus(io, objectServer, assocPath, assocMaps);
 }
@@ -199,7 +207,7 @@ void checkAssociationEndpointRemoves(
         {
             // The association is still there.  Check if the endpoints
             // changed.
-            boost::container::flat_set<std::string> toRemove;
+            EndpointSet toRemove;
 
             for (const auto& originalEndpoint : originalEndpoints)
             {
@@ -221,8 +229,7 @@ void checkAssociationEndpointRemoves(
 
 static void addEndpointsToAssocIfaces(
     boost::asio::io_context& io, sdbusplus::asio::object_server& objectServer,
-    const std::string& assocPath,
-    const boost::container::flat_set<std::string>& endpointPaths,
+    const std::string& assocPath, const EndpointSet& endpointPaths,
     AssociationMaps& assocMaps)
 {
     auto& iface = assocMaps.ifaces[assocPath];
@@ -236,6 +243,7 @@ static void addEndpointsToAssocIfaces(
             endpoints.push_back(e);
         }
     }
+    std::get<endpointLookupPos>(iface).clear();
     scheduleUpdateEndpointsOnDbus(io, objectServer, assocPath, assocMaps);
 }
 
@@ -379,12 +387,11 @@ void addSingleAssociation(
     const std::string& owner, const std::string& ownerPath,
     AssociationMaps& assocMaps)
 {
-    boost::container::flat_set<std::string> endpoints{endpoint};
+    EndpointSet e{endpoint};
 
-    addEndpointsToAssocIfaces(io, server, assocPath, endpoints, assocMaps);
+    addEndpointsToAssocIfaces(io, server, assocPath, e, assocMaps);
 
     AssociationPaths objects;
-    boost::container::flat_set e{endpoint};
     objects.emplace(assocPath, e);
 
     auto a = assocMaps.owners.find(ownerPath);
@@ -485,7 +492,42 @@ void checkIfPendingAssociation(
 
     if (pending->second.empty())
     {
-        assocMaps.pending.erase(objectPath);
+        assocMaps.pending.erase(pending);
+    }
+}
+
+void checkIfPendingAssociations(
+    boost::asio::io_context& io, const std::vector<std::string>& objectPaths,
+    const InterfaceMapType& interfaceMap, AssociationMaps& assocMaps,
+    sdbusplus::asio::object_server& server)
+{
+    // Matches are collected first, since creating the associations changes
+    // the pending map
+    std::vector<std::string> matches;
+    if (assocMaps.pending.size() < objectPaths.size())
+    {
+        for (const auto& [path, endpoints] : assocMaps.pending)
+        {
+            if (std::ranges::binary_search(objectPaths, path.str()))
+            {
+                matches.emplace_back(path.str());
+            }
+        }
+    }
+    else
+    {
+        for (const std::string& path : objectPaths)
+        {
+            if (assocMaps.pending.contains(path))
+            {
+                matches.emplace_back(path);
+            }
+        }
+    }
+
+    for (const std::string& path : matches)
+    {
+        checkIfPendingAssociation(io, path, interfaceMap, assocMaps, server);
     }
 }
 
@@ -493,15 +535,23 @@ void findAssociations(const std::string& endpointPath,
                       AssociationMaps& assocMaps,
                       FindAssocResults& associationData)
 {
+    // A path that was never stored can't be an endpoint
+    PathAtom endpointAtom = PathAtom::lookup(endpointPath);
+    if (endpointAtom.empty())
+    {
+        return;
+    }
+
     for (const auto& [sourcePath, owners] : assocMaps.owners)
     {
         for (const auto& [owner, assocs] : owners)
         {
-            for (const auto& [assocPath, endpoints] : assocs)
+            for (const auto& [assocAtom, endpoints] : assocs)
             {
-                if (std::find(endpoints.begin(), endpoints.end(),
-                              endpointPath) != endpoints.end())
+                if (endpoints.contains(endpointAtom))
                 {
+                    const std::string& assocPath = assocAtom;
+
                     // assocPath is <path>/<type> which tells us what is on the
                     // other side of the association.
                     auto pos = assocPath.rfind('/');
@@ -522,7 +572,8 @@ void findAssociations(const std::string& endpointPath,
                                           otherEndpoints.end(), otherPath);
                             if (endpoint != otherEndpoints.end())
                             {
-                                return ap.first.starts_with(endpointPath + '/');
+                                return ap.first.str().starts_with(
+                                    endpointPath + '/');
                             }
                             return false;
                         });
@@ -530,8 +581,8 @@ void findAssociations(const std::string& endpointPath,
                     if (a != assocs.end())
                     {
                         // Pull out the type from endpointPath/<type>
-                        pos = a->first.rfind('/');
-                        auto thisType = a->first.substr(pos + 1);
+                        pos = a->first.str().rfind('/');
+                        auto thisType = a->first.str().substr(pos + 1);
 
                         // Now we know the full association:
                         // endpointPath/thisType -> otherPath/otherType
@@ -567,6 +618,7 @@ static void removeAssociationIfacesEntry(
         if (e != endpoints.end())
         {
             endpoints.erase(e);
+            std::get<endpointLookupPos>(assoc->second).clear();
 
             scheduleUpdateEndpointsOnDbus(io, server, assocPath, assocMaps);
         }
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "types.hpp"
+#include "interface_map.hpp"
 
 constexpr const char* xyzAssociationInterface =
     "xyz.openbmc_project.Association";
@@ -41,8 +41,7 @@ void removeAssociation(boost::asio::io_context& io,
  */
 void removeAssociationEndpoints(
     boost::asio::io_context& io, sdbusplus::asio::object_server& objectServer,
-    const std::string& assocPath,
-    const boost::container::flat_set<std::string>& endpointsToRemove,
+    const std::string& assocPath, const EndpointSet& endpointsToRemove,
     AssociationMaps& assocMaps);
 
 /** @brief Check and remove any changed associations
@@ -162,6 +161,24 @@ void checkIfPendingAssociation(
     const InterfaceMapType& interfaceMap, AssociationMaps& assocMaps,
     sdbusplus::asio::object_server& server);
 
+/** @brief Create the real associations of pending associations for a
+ *         batch of paths that were added to D-Bus.
+ *
+ * The same as checkIfPendingAssociation() for each of the paths, except
+ * that the pending associations are only matched against the batch once.
+ * Whichever of the two is smaller is walked and looked up in the other.
+ *
+ * @param[in] io            - io context
+ * @param[in] objectPaths   - the paths to check, sorted
+ * @param[in] interfaceMap  - The master interface map
+ * @param[in,out] assocMaps - The association maps
+ * @param[in,out] server    - sdbus system object
+ */
+void checkIfPendingAssociations(
+    boost::asio::io_context& io, const std::vector<std::string>& objectPaths,
+    const InterfaceMapType& interfaceMap, AssociationMaps& assocMaps,
+    sdbusplus::asio::object_server& server);
+
 /** @brief Find all associations in the association owners map with the
  *         specified endpoint path.
  *
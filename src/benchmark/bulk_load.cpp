@@ -0,0 +1,82 @@
+#include "src/bulk_load.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+static const std::string service = "xyz.openbmc_project.HwmonTempSensor";
+
+static const std::vector<std::string_view> sensorInterfaces = {
+    "org.freedesktop.DBus.Introspectable", "org.freedesktop.DBus.Peer",
+    "org.freedesktop.DBus.Properties", "xyz.openbmc_project.Sensor.Value",
+    "xyz.openbmc_project.State.Decorator.OperationalStatus",
+    "xyz.openbmc_project.Association.Definitions"};
+
+// The sensor paths of one service, in the order their introspection
+// replies arrive.  With a call outstanding for every child, that is about
+// as good as random.
+static std::vector<std::string> scanOrder(size_t sensors)
+{
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < sensors; i++)
+    {
+        paths.push_back("/xyz/openbmc_project/sensors/temperature/sensor" +
+                        std::to_string(i));
+    }
+    std::shuffle(paths.begin(), paths.end(), std::mt19937(sensors));
+    return paths;
+}
+
+// What a scan did before it was staged: each reply added straight to the
+// map, one interface at a time
+static void scanPerInterface(benchmark::State& state)
+{
+    const std::vector<std::string> paths =
+        scanOrder(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        InterfaceMapType interfaceMap;
+        for (const std::string& path : paths)
+        {
+            auto pathIt = interfaceMap.emplace(path).first;
+            for (std::string_view interface : sensorInterfaces)
+            {
+                interfaceMap.addInterface(pathIt, service, interface);
+            }
+        }
+        benchmark::DoNotOptimize(interfaceMap.size());
+    }
+}
+BENCHMARK(scanPerInterface)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+static void scanBulkLoad(benchmark::State& state)
+{
+    const std::vector<std::string> paths =
+        scanOrder(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        InterfaceMapType interfaceMap;
+        BulkLoad bulkLoad(service);
+        for (const std::string& path : paths)
+        {
+            bulkLoad.add(path, sensorInterfaces);
+        }
+        benchmark::DoNotOptimize(bulkLoad.commit(interfaceMap).size());
+    }
+}
+BENCHMARK(scanBulkLoad)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
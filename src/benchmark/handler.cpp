@@ -0,0 +1,222 @@
+#include "src/benchmark/util/sensor_tree.hpp"
+#include "src/handler.hpp"
+#include "src/marshalled_size.hpp"
+
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+static void getSubTreeAll(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap =
+        makeSensorTree(static_cast<size_t>(state.range(0)));
+    std::vector<std::string> interfaces;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getSubTree(interfaceMap, "/", 0, interfaces));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(getSubTreeAll)
+    ->Arg(10000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+// What an inventory walk that only needs the services asks for
+static void getSubTreeCompactConnections(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap =
+        makeSensorTree(static_cast<size_t>(state.range(0)));
+    std::vector<std::string> interfaces;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getSubTreeCompact(
+            interfaceMap, "/", 0, interfaces,
+            static_cast<uint32_t>(SubTreeProjection::connections)));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(getSubTreeCompactConnections)
+    ->Arg(10000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+// The reply size of each projection of the whole sensor tree, against a
+// GetSubTree reply with the same paths
+static void compactReplySize(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap = makeSensorTree(10000);
+    std::vector<std::string> interfaces;
+    auto projection = static_cast<uint32_t>(state.range(0));
+    size_t subTreeBytes =
+        marshalledSize(getSubTree(interfaceMap, "/", 0, interfaces));
+    size_t compactBytes = 0;
+    for (auto _ : state)
+    {
+        compactBytes = marshalledSize(
+            getSubTreeCompact(interfaceMap, "/", 0, interfaces, projection));
+    }
+    state.counters["subtree_bytes"] = static_cast<double>(subTreeBytes);
+    state.counters["compact_bytes"] = static_cast<double>(compactBytes);
+    state.counters["ratio"] = static_cast<double>(compactBytes) /
+                              static_cast<double>(subTreeBytes);
+}
+BENCHMARK(compactReplySize)
+    ->DenseRange(static_cast<int64_t>(SubTreeProjection::paths),
+                 static_cast<int64_t>(SubTreeProjection::interfaces))
+    ->Unit(benchmark::kMillisecond);
+
+static void getSubTreeFiltered(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap =
+        makeSensorTree(static_cast<size_t>(state.range(0)));
+    std::vector<std::string> interfaces = {"xyz.openbmc_project.Sensor.Value"};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getSubTree(
+            interfaceMap, "/xyz/openbmc_project/sensors", 0, interfaces));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(getSubTreeFiltered)
+    ->Arg(10000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMillisecond);
+
+// The ten sensors numbered 10 to 19, whichever type they are
+static void getSubTreeByPatternSensors(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap =
+        makeSensorTree(static_cast<size_t>(state.range(0)));
+    std::vector<std::string> interfaces;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getSubTreeByPattern(
+            interfaceMap, "/xyz/openbmc_project/sensors/*/sensor1?",
+            interfaces));
+    }
+}
+BENCHMARK(getSubTreeByPatternSensors)
+    ->Arg(10000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+
+static void getAncestorsOfSensor(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap =
+        makeSensorTree(static_cast<size_t>(state.range(0)));
+    std::vector<std::string> interfaces = {
+        "org.freedesktop.DBus.ObjectManager"};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getAncestors(
+            interfaceMap, "/xyz/openbmc_project/sensors/temperature/sensor0",
+            interfaces));
+    }
+}
+BENCHMARK(getAncestorsOfSensor)
+    ->Arg(10000)
+    ->Arg(50000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+
+static void getObjectHit(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap = makeSensorTree(10000);
+    std::vector<std::string> interfaces;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(tryGetObject(
+            interfaceMap, "/xyz/openbmc_project/sensors/temperature/sensor0",
+            interfaces));
+    }
+}
+BENCHMARK(getObjectHit)->Unit(benchmark::kNanosecond);
+
+// A client waiting for its object to appear, as the thrown error that
+// sdbusplus::asio turns into the error reply
+static void getObjectMissThrown(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap = makeSensorTree(10000);
+    std::vector<std::string> interfaces;
+    for (auto _ : state)
+    {
+        try
+        {
+            benchmark::DoNotOptimize(getObject(
+                interfaceMap, "/xyz/openbmc_project/sensors/temperature/none",
+                interfaces));
+        }
+        catch (const std::exception& e)
+        {
+            benchmark::DoNotOptimize(e.what());
+        }
+    }
+}
+BENCHMARK(getObjectMissThrown)->Unit(benchmark::kNanosecond);
+
+// The same miss as the result the direct methods reply with
+static void getObjectMissResult(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap = makeSensorTree(10000);
+    std::vector<std::string> interfaces;
+    for (auto _ : state)
+    {
+        auto result = tryGetObject(
+            interfaceMap, "/xyz/openbmc_project/sensors/temperature/none",
+            interfaces);
+        benchmark::DoNotOptimize(errorName(result.error()));
+    }
+}
+BENCHMARK(getObjectMissResult)->Unit(benchmark::kNanosecond);
+
+// A board per id match, each associated with its share of 200 sensors
+static void getAssociatedSubTreeByIdBoards(benchmark::State& state)
+{
+    constexpr size_t sensors = 200;
+    auto boards = static_cast<size_t>(state.range(0));
+    InterfaceMapType interfaceMap = makeSensorTree(10000);
+    AssociationMaps associationMaps;
+    for (size_t i = 0; i < boards; i++)
+    {
+        std::string board = "/xyz/openbmc_project/inventory/system/chassis" +
+                            std::to_string(i) + "/board";
+        interfaceMap.addInterface(interfaceMap.emplace(board).first,
+                                  "xyz.openbmc_project.EntityManager",
+                                  "xyz.openbmc_project.Inventory.Item.Board");
+
+        Endpoints& endpoints =
+            std::get<endpointsPos>(associationMaps.ifaces[board + "/sensors"]);
+        for (size_t j = i; j < sensors; j += boards)
+        {
+            endpoints.emplace_back("/xyz/openbmc_project/sensors/" +
+                                   std::string(j % 2 != 0 ? "voltage"
+                                                          : "temperature") +
+                                   "/sensor" + std::to_string(j));
+        }
+    }
+
+    std::vector<std::string> subtreeInterfaces = {
+        "xyz.openbmc_project.Inventory.Item.Board"};
+    std::vector<std::string> endpointInterfaces = {
+        "xyz.openbmc_project.Sensor.Value"};
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(getAssociatedSubTreeById(
+            interfaceMap, associationMaps, "board", "/xyz/openbmc_project",
+            subtreeInterfaces, "sensors", endpointInterfaces));
+    }
+}
+BENCHMARK(getAssociatedSubTreeByIdBoards)
+    ->Arg(1)
+    ->Arg(32)
+    ->Arg(200)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
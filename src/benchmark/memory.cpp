@@ -0,0 +1,229 @@
+#include "src/benchmark/util/sensor_tree.hpp"
+#include "src/bulk_load.hpp"
+#include "src/handler.hpp"
+#include "src/types.hpp"
+
+#include <malloc.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// Every allocation made with operator new.  The replacements aren't
+// inlined, so the compiler doesn't see memory from operator new handed to
+// free().
+static std::atomic<size_t> allocations;
+
+[[gnu::noinline]] void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* memory = std::malloc(size);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+[[gnu::noinline]] void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+[[gnu::noinline]] void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+// The association maps a mapper has for the sensor tree: every sensor
+// points at its chassis, and the chassis points back at all of them
+static void addSensorAssociations(const InterfaceMapType& interfaceMap,
+                                  AssociationMaps& assocMaps)
+{
+    const std::string chassis = "/xyz/openbmc_project/inventory/system/chassis";
+    const std::string service = "xyz.openbmc_project.HwmonTempSensor";
+    const std::string allSensors = chassis + "/all_sensors";
+    for (const auto& [path, _] : interfaceMap)
+    {
+        const std::string& sensor = path;
+        if (sensor.find("/sensor", sensor.rfind('/')) == std::string::npos)
+        {
+            continue;
+        }
+        std::string toChassis = sensor + "/chassis";
+        std::get<endpointsPos>(assocMaps.ifaces[toChassis])
+            .emplace_back(chassis);
+        std::get<endpointsPos>(assocMaps.ifaces[allSensors])
+            .emplace_back(sensor);
+
+        AssociationPaths& owned = assocMaps.owners[sensor][service];
+        owned[toChassis].emplace(chassis);
+        owned[allSensors].emplace(sensor);
+    }
+}
+
+static size_t heapInUse()
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+static size_t residentBytes()
+{
+    size_t pages = 0;
+    size_t resident = 0;
+    std::ifstream("/proc/self/statm") >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// What the interface map and association maps of a large system take up.
+// Only run once, since memory freed by one run is reused by the next.
+static void sensorTreeMemory(benchmark::State& state)
+{
+    const auto sensors = static_cast<size_t>(state.range(0));
+    for (auto _ : state)
+    {
+        size_t heapBefore = heapInUse();
+        size_t residentBefore = residentBytes();
+
+        InterfaceMapType interfaceMap = makeSensorTree(sensors);
+        AssociationMaps assocMaps;
+        addSensorAssociations(interfaceMap, assocMaps);
+
+        size_t heap = heapInUse() - heapBefore;
+        state.counters["heap_bytes"] = static_cast<double>(heap);
+        state.counters["rss_bytes"] =
+            static_cast<double>(residentBytes() - residentBefore);
+        state.counters["heap_per_path"] =
+            static_cast<double>(heap) /
+            static_cast<double>(interfaceMap.size());
+    }
+}
+BENCHMARK(sensorTreeMemory)
+    ->Arg(50000)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+// What a GetSubTree reply for the whole sensor tree takes to build, before
+// it is serialized.  Most of it is the connection and interface names of
+// each path.
+static void subTreeReplyMemory(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap =
+        makeSensorTree(static_cast<size_t>(state.range(0)));
+    std::vector<std::string> interfaces;
+    for (auto _ : state)
+    {
+        size_t allocationsBefore = allocations;
+        size_t heapBefore = heapInUse();
+        size_t residentBefore = residentBytes();
+
+        auto result = getSubTree(interfaceMap, "/", 0, interfaces);
+
+        auto paths = static_cast<double>(result.size());
+        state.counters["allocs_per_path"] =
+            static_cast<double>(allocations - allocationsBefore) / paths;
+        state.counters["heap_per_path"] =
+            static_cast<double>(heapInUse() - heapBefore) / paths;
+        state.counters["rss_bytes"] =
+            static_cast<double>(residentBytes() - residentBefore);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(subTreeReplyMemory)
+    ->Arg(50000)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+// The allocations of the names of one path, which every query result is
+// made of
+static void connectionNamesAllocations(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap = makeSensorTree(1);
+    const ConnectionIds& connections =
+        interfaceMap.find("/xyz/openbmc_project/sensors/temperature/sensor0")
+            ->second;
+    size_t allocationsBefore = allocations;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(toConnectionNames(connections));
+    }
+    state.counters["allocs_per_path"] =
+        static_cast<double>(allocations - allocationsBefore) /
+        static_cast<double>(state.iterations());
+}
+BENCHMARK(connectionNamesAllocations);
+
+// How much a service that keeps coming and going, with new paths each
+// time, makes the mapper grow, while another service stays on the bus and
+// changes a little in between.  The growth is measured after the first
+// rounds, in which the heap reaches its size.
+static void nameChangeChurnMemory(benchmark::State& state)
+{
+    const auto rounds = static_cast<size_t>(state.range(0));
+    const std::string sensors = "/xyz/openbmc_project/sensors/";
+    const std::vector<std::string_view> interfaces = {
+        "org.freedesktop.DBus.Introspectable", "org.freedesktop.DBus.Peer",
+        "org.freedesktop.DBus.Properties", "xyz.openbmc_project.Sensor.Value"};
+    for (auto _ : state)
+    {
+        InterfaceMapType interfaceMap;
+        BulkLoad stable("stable.svc");
+        for (size_t i = 0; i < 1000; i++)
+        {
+            stable.add(sensors + "stable/sensor" + std::to_string(i),
+                       interfaces);
+        }
+        stable.commit(interfaceMap);
+
+        auto hotPlug = [&](size_t round) {
+            BulkLoad scan("churn.svc");
+            for (size_t i = 0; i < 500; i++)
+            {
+                scan.add(sensors + "temperature/hotplug" +
+                             std::to_string(round) + "_" + std::to_string(i),
+                         interfaces);
+            }
+            scan.commit(interfaceMap);
+
+            auto extra = interfaceMap.emplace(sensors + "stable/extra" +
+                                              std::to_string(round % 16));
+            interfaceMap.addInterface(extra.first, "stable.svc",
+                                      "xyz.openbmc_project.Sensor.Value");
+
+            // The service leaves the bus
+            interfaceMap.removeConnection("churn.svc");
+        };
+
+        size_t round = 0;
+        for (; round < rounds / 4; round++)
+        {
+            hotPlug(round);
+        }
+        size_t heapBefore = heapInUse();
+        size_t residentBefore = residentBytes();
+        for (; round < rounds; round++)
+        {
+            hotPlug(round);
+        }
+
+        state.counters["heap_growth"] =
+            static_cast<double>(heapInUse()) - static_cast<double>(heapBefore);
+        state.counters["rss_growth"] = static_cast<double>(residentBytes()) -
+                                       static_cast<double>(residentBefore);
+    }
+}
+BENCHMARK(nameChangeChurnMemory)
+    ->Arg(200)
+    ->Iterations(1)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
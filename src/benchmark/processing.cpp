@@ -0,0 +1,61 @@
+#include "src/benchmark/util/sensor_tree.hpp"
+#include "src/processing.hpp"
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// A sensor service that keeps removing and adding back its sensors, like
+// during a hot-unplug storm.  The parents D-Bus created for the service
+// only have the default interfaces, so every removal checks if they are
+// still needed.
+static void interfacesRemovedChurn(benchmark::State& state)
+{
+    const auto sensors = static_cast<size_t>(state.range(0));
+    const std::string service = "xyz.openbmc_project.HwmonTempSensor";
+    InterfaceMapType interfaceMap = makeSensorTree(sensors);
+
+    std::vector<std::string> paths;
+    for (const auto& [path, _] : interfaceMap)
+    {
+        if (path.str().find("/sensor") != std::string::npos)
+        {
+            paths.push_back(path);
+        }
+    }
+    for (const auto& path : paths)
+    {
+        for (std::string parent = path.substr(0, path.rfind('/'));
+             parent.size() > 1; parent = parent.substr(0, parent.rfind('/')))
+        {
+            for (const char* interface :
+                 {"org.freedesktop.DBus.Introspectable",
+                  "org.freedesktop.DBus.Peer",
+                  "org.freedesktop.DBus.Properties"})
+            {
+                interfaceMap.addInterface(interfaceMap.emplace(parent).first,
+                                          service, interface);
+            }
+        }
+    }
+
+    size_t next = 0;
+    for (auto _ : state)
+    {
+        const std::string& path = paths[next];
+        next = (next + 1) % paths.size();
+
+        interfaceMap.erase(interfaceMap.find(path));
+        removeUnneededParents(path, service, interfaceMap);
+        interfaceMap.addInterface(interfaceMap.emplace(path).first, service,
+                                  "xyz.openbmc_project.Sensor.Value");
+    }
+}
+BENCHMARK(interfacesRemovedChurn)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,94 @@
+#include "src/benchmark/util/sensor_tree.hpp"
+#include "src/handler.hpp"
+#include "src/reply_cache.hpp"
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/exception.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+// Replies can only be made to a sealed call, which needs a bus connection
+static std::optional<sdbusplus::message_t> makeCall()
+{
+    try
+    {
+        sdbusplus::bus_t bus = sdbusplus::bus::new_default();
+        sdbusplus::message_t call = bus.new_method_call(
+            "xyz.openbmc_project.ObjectMapper",
+            "/xyz/openbmc_project/object_mapper",
+            "xyz.openbmc_project.ObjectMapper", "GetSubTree");
+        if (sd_bus_message_seal(call.get(), 1, 0) >= 0)
+        {
+            return call;
+        }
+    }
+    catch (const sdbusplus::exception_t&)
+    {}
+    return std::nullopt;
+}
+
+// What the register_method lambda does: build the result, then marshal it
+static void replyFromResult(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap =
+        makeSensorTree(static_cast<size_t>(state.range(0)));
+    std::vector<std::string> interfaces = {"xyz.openbmc_project.Sensor.Value"};
+    std::optional<sdbusplus::message_t> call = makeCall();
+    if (!call)
+    {
+        state.SkipWithError("Could not make a method call");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        sdbusplus::message_t reply = call->new_method_return();
+        reply.append(getSubTree(interfaceMap, "/xyz/openbmc_project/sensors",
+                                0, interfaces));
+        benchmark::DoNotOptimize(reply.get());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(replyFromResult)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMicrosecond);
+
+// What a reply cache hit does: copy the body of an earlier reply
+static void replyFromCache(benchmark::State& state)
+{
+    InterfaceMapType interfaceMap =
+        makeSensorTree(static_cast<size_t>(state.range(0)));
+    std::vector<std::string> interfaces = {"xyz.openbmc_project.Sensor.Value"};
+    std::optional<sdbusplus::message_t> call = makeCall();
+    if (!call)
+    {
+        state.SkipWithError("Could not make a method call");
+        return;
+    }
+    sdbusplus::message_t cached = call->new_method_return();
+    cached.append(getSubTree(interfaceMap, "/xyz/openbmc_project/sensors", 0,
+                             interfaces));
+    if (sd_bus_message_seal(cached.get(), 2, 0) < 0)
+    {
+        state.SkipWithError("Could not seal the cached reply");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        sdbusplus::message_t reply = ReplyCache::copyReply(*call, cached);
+        benchmark::DoNotOptimize(reply.get());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(replyFromCache)
+    ->Arg(1000)
+    ->Arg(10000)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "src/interface_map.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A sensor tree like a large system has, with every sensor also owned by
+// the mapper for its associations so results have to merge connections
+inline InterfaceMapType makeSensorTree(size_t sensors)
+{
+    static const std::vector<std::string> types = {
+        "temperature", "voltage", "current", "power",
+        "fan_tach",    "energy",  "airflow", "utilization"};
+
+    InterfaceMapType interfaceMap;
+    for (const std::string& path :
+         {std::string("/xyz"), std::string("/xyz/openbmc_project"),
+          std::string("/xyz/openbmc_project/sensors")})
+    {
+        interfaceMap.addConnection(interfaceMap.emplace(path).first,
+                                   "xyz.openbmc_project.HwmonTempSensor");
+    }
+    for (size_t i = 0; i < sensors; i++)
+    {
+        std::string path = "/xyz/openbmc_project/sensors/" +
+                           types[i % types.size()] + "/sensor" +
+                           std::to_string(i);
+        auto pathIt = interfaceMap.emplace(path).first;
+        for (const char* interface :
+             {"org.freedesktop.DBus.Introspectable",
+              "org.freedesktop.DBus.Peer", "org.freedesktop.DBus.Properties",
+              "xyz.openbmc_project.Sensor.Value",
+              "xyz.openbmc_project.State.Decorator.OperationalStatus",
+              "xyz.openbmc_project.Association.Definitions"})
+        {
+            interfaceMap.addInterface(
+                pathIt, "xyz.openbmc_project.HwmonTempSensor", interface);
+        }
+        interfaceMap.addInterface(pathIt, "xyz.openbmc_project.ObjectMapper",
+                                  "xyz.openbmc_project.Association");
+    }
+    return interfaceMap;
+}
@@ -0,0 +1,123 @@
+#include "bulk_load.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+void BulkLoad::add(const std::string& path,
+                   const std::vector<std::string_view>& interfaces)
+{
+    if (cancelled)
+    {
+        return;
+    }
+    if (!staged)
+    {
+        staged.emplace();
+    }
+
+    NameTable& names = nameTable();
+    std::pmr::vector<NameId> ids(&staged->arena);
+    ids.reserve(interfaces.size());
+    for (std::string_view interface : interfaces)
+    {
+        ids.emplace_back(names.intern(interface));
+    }
+    std::ranges::sort(ids);
+    auto [first, last] = std::ranges::unique(ids);
+    ids.erase(first, last);
+
+    auto found = staged->index.find(path);
+    if (found == staged->index.end())
+    {
+        Entry& entry = staged->entries.emplace_back(
+            Entry{std::pmr::string(path, &staged->arena), std::move(ids)});
+        staged->index.emplace(entry.path, staged->entries.size() - 1);
+        return;
+    }
+
+    // A path introspected twice gets the interfaces of both replies
+    std::pmr::vector<NameId>& current =
+        staged->entries[found->second].interfaces;
+    std::pmr::vector<NameId> merged(&staged->arena);
+    merged.reserve(current.size() + ids.size());
+    std::ranges::set_union(current, ids, std::back_inserter(merged));
+    current = std::move(merged);
+}
+
+bool BulkLoad::remove(std::string_view path,
+                      const std::vector<std::string>& interfaces)
+{
+    if (!staged)
+    {
+        return false;
+    }
+    auto found = staged->index.find(path);
+    if (found == staged->index.end())
+    {
+        return false;
+    }
+
+    Entry& entry = staged->entries[found->second];
+    const NameTable& names = nameTable();
+    for (const std::string& interface : interfaces)
+    {
+        auto id = names.find(interface);
+        if (!id)
+        {
+            continue;
+        }
+        auto it = std::ranges::lower_bound(entry.interfaces, *id);
+        if (it != entry.interfaces.end() && *it == *id)
+        {
+            entry.interfaces.erase(it);
+        }
+    }
+
+    // The same as the map, which erases a path with no connections left
+    if (entry.interfaces.empty())
+    {
+        entry.dropped = true;
+        staged->index.erase(found);
+    }
+    return true;
+}
+
+void BulkLoad::cancel()
+{
+    cancelled = true;
+    staged.reset();
+}
+
+std::vector<std::string> BulkLoad::commit(InterfaceMapType& interfaceMap)
+{
+    std::vector<std::string> added;
+    if (!staged)
+    {
+        return added;
+    }
+
+    std::vector<Entry*> sorted;
+    sorted.reserve(staged->index.size());
+    for (Entry& entry : staged->entries)
+    {
+        if (!entry.dropped && !entry.interfaces.empty())
+        {
+            sorted.emplace_back(&entry);
+        }
+    }
+    std::ranges::sort(sorted, {}, &Entry::path);
+
+    auto hint = interfaceMap.end();
+    for (Entry* entry : sorted)
+    {
+        auto [pathIt, inserted] = interfaceMap.emplace(hint, entry->path);
+        interfaceMap.addInterfaces(pathIt, connectionName, entry->interfaces);
+        hint = std::next(pathIt);
+        if (inserted)
+        {
+            added.emplace_back(entry->path);
+        }
+    }
+    staged.reset();
+    return added;
+}
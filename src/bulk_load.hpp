@@ -0,0 +1,129 @@
+#pragma once
+
+#include "interface_map.hpp"
+
+#include <cstddef>
+#include <deque>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// The most paths a scan stages before they are added to the map
+constexpr size_t bulkLoadBatchPaths = 1024;
+
+/** @brief The introspection results of one service, staged to be added to
+ *         the interface map at once.
+ *
+ * Introspecting a service replies with one object path at a time, in
+ * whatever order the service lists its children.  Adding each of them to
+ * the interface map as it arrives inserts it into the middle of its
+ * parent's children in the path tree, and rebuilds the interface set of
+ * the path once per interface.  Instead, paths are appended to a buffer
+ * here and added to the map in path order, so children are mostly
+ * appended to the tree and each interface set is built once.  They are
+ * added when the scan of the service completes, or whenever
+ * bulkLoadBatchPaths of them are staged, so clients don't have to wait
+ * for the whole scan of a large service to find its first paths.
+ *
+ * Signals from the service can arrive before its scan completes.
+ * Interfaces it adds go straight to the map and are merged with the
+ * staged ones on commit, interfaces it removes have to be removed here as
+ * well, and if it leaves the bus the whole scan has to be cancelled.
+ *
+ * Everything staged is allocated from an arena of the scan, which is freed
+ * at once on commit or cancel, so the many short-lived allocations of a
+ * scan don't end up scattered between the ones the map keeps.
+ */
+class BulkLoad
+{
+  public:
+    /** @brief Constructor
+     *
+     * @param[in] connection - The service the scan is of
+     */
+    explicit BulkLoad(std::string connection) :
+        connectionName(std::move(connection))
+    {}
+
+    /** @brief Stage the interfaces the service has on an object path
+     *
+     * A path without interfaces isn't added to the map on commit, the same
+     * as one whose interfaces were all removed, since nothing would ever
+     * erase it from the map.
+     *
+     * @param[in] path       - The object path
+     * @param[in] interfaces - The interface names
+     */
+    void add(const std::string& path,
+             const std::vector<std::string_view>& interfaces);
+
+    /** @brief Remove interfaces from a staged path
+     *
+     * A path without any interfaces left is dropped.
+     *
+     * @param[in] path       - The object path
+     * @param[in] interfaces - The interface names the service removed
+     *
+     * @return True if the path was staged
+     */
+    bool remove(std::string_view path,
+                const std::vector<std::string>& interfaces);
+
+    /** @brief Drop everything staged and ignore what is staged after it,
+     *         for a service that left the bus
+     */
+    void cancel();
+
+    /** @brief Add the staged paths to an interface map, in path order
+     *
+     * Staging can go on afterwards, for the next batch of the scan.
+     *
+     * @param[in] interfaceMap - The interface map
+     *
+     * @return The object paths that weren't in the map before, in path
+     *         order
+     */
+    std::vector<std::string> commit(InterfaceMapType& interfaceMap);
+
+    const std::string& connection() const
+    {
+        return connectionName;
+    }
+
+    /** @brief The number of staged paths */
+    size_t size() const
+    {
+        return staged ? staged->index.size() : 0;
+    }
+
+  private:
+    struct Entry
+    {
+        std::pmr::string path;
+        // Sorted and without duplicates
+        std::pmr::vector<NameId> interfaces;
+        bool dropped = false;
+    };
+
+    // The arena goes after everything that is allocated from it
+    struct Staged
+    {
+        Staged() : entries(&arena), index(&arena) {}
+
+        std::pmr::monotonic_buffer_resource arena;
+
+        // A deque so the keys of index stay valid as entries are appended
+        std::pmr::deque<Entry> entries;
+        std::pmr::unordered_map<std::string_view, size_t> index;
+    };
+
+    std::string connectionName;
+    bool cancelled = false;
+
+    // Only there while something is staged
+    std::optional<Staged> staged;
+};
@@ -0,0 +1,162 @@
+#include "direct_methods.hpp"
+
+#include "handler.hpp"
+
+#include <sdbusplus/exception.hpp>
+
+#include <cerrno>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+template <typename T>
+QueryResult<void> sendResult(sdbusplus::message_t& call,
+                             QueryResult<T>&& result)
+{
+    if (!result)
+    {
+        return std::unexpected(result.error());
+    }
+    sdbusplus::message_t reply = call.new_method_return();
+    reply.append(*result);
+    reply.method_return();
+    return {};
+}
+
+} // namespace
+
+DirectMethods::DirectMethods(const InterfaceMapType& map,
+                             const AssociationMaps& associations,
+                             ReplyCache& replies, MissCache& misses) :
+    interfaceMap(map), associationMaps(associations), replyCache(replies),
+    missCache(misses)
+{}
+
+QueryResult<void> DirectMethods::getObject(sdbusplus::message_t& call)
+{
+    std::string path;
+    std::vector<std::string> interfaces;
+    call.read(path, interfaces);
+
+    return sendResult(call,
+                      tryGetObject(interfaceMap, missCache, path, interfaces));
+}
+
+QueryResult<void> DirectMethods::getAncestors(sdbusplus::message_t& call)
+{
+    std::string reqPath;
+    std::vector<std::string> interfaces;
+    call.read(reqPath, interfaces);
+
+    return sendResult(call, tryGetAncestors(interfaceMap, reqPath, interfaces));
+}
+
+QueryResult<void> DirectMethods::getSubTree(sdbusplus::message_t& call)
+{
+    return replyCache.getSubTree(call);
+}
+
+QueryResult<void> DirectMethods::getSubTreePaths(sdbusplus::message_t& call)
+{
+    return replyCache.getSubTreePaths(call);
+}
+
+QueryResult<void>
+    DirectMethods::getAssociatedSubTreeById(sdbusplus::message_t& call)
+{
+    std::string id;
+    std::string objectPath;
+    std::vector<std::string> subtreeInterfaces;
+    std::string association;
+    std::vector<std::string> endpointInterfaces;
+    call.read(id, objectPath, subtreeInterfaces, association,
+              endpointInterfaces);
+
+    return sendResult(call, tryGetAssociatedSubTreeById(
+                                interfaceMap, associationMaps, id, objectPath,
+                                subtreeInterfaces, association,
+                                endpointInterfaces));
+}
+
+QueryResult<void>
+    DirectMethods::getAssociatedSubTreePathsById(sdbusplus::message_t& call)
+{
+    std::string id;
+    std::string objectPath;
+    std::vector<std::string> subtreeInterfaces;
+    std::string association;
+    std::vector<std::string> endpointInterfaces;
+    call.read(id, objectPath, subtreeInterfaces, association,
+              endpointInterfaces);
+
+    return sendResult(call, tryGetAssociatedSubTreePathsById(
+                                interfaceMap, associationMaps, id, objectPath,
+                                subtreeInterfaces, association,
+                                endpointInterfaces));
+}
+
+int DirectMethods::dispatch(sd_bus_message* msg, void* context,
+                            sd_bus_error* error, Method method)
+{
+    try
+    {
+        sdbusplus::message_t call(msg);
+        QueryResult<void> result =
+            (static_cast<DirectMethods*>(context)->*method)(call);
+        if (!result)
+        {
+            return sd_bus_error_set(error, errorName(result.error()),
+                                    errorDescription(result.error()));
+        }
+    }
+    // Only for what isn't a query error, like a call that can't be read
+    catch (const sdbusplus::exception_t& e)
+    {
+        return sd_bus_error_set(error, e.name(), e.description());
+    }
+    catch (const std::exception&)
+    {
+        return -EINVAL;
+    }
+    return 1;
+}
+
+const sdbusplus::vtable_t DirectMethods::vtable[] = {
+    sdbusplus::vtable::start(),
+    sdbusplus::vtable::method(
+        "GetObject", "sas", "a{sas}",
+        [](sd_bus_message* msg, void* context, sd_bus_error* error) {
+            return dispatch(msg, context, error, &DirectMethods::getObject);
+        }),
+    sdbusplus::vtable::method(
+        "GetAncestors", "sas", "a{sa{sas}}",
+        [](sd_bus_message* msg, void* context, sd_bus_error* error) {
+            return dispatch(msg, context, error, &DirectMethods::getAncestors);
+        }),
+    sdbusplus::vtable::method(
+        "GetSubTree", "sias", "a{sa{sas}}",
+        [](sd_bus_message* msg, void* context, sd_bus_error* error) {
+            return dispatch(msg, context, error, &DirectMethods::getSubTree);
+        }),
+    sdbusplus::vtable::method(
+        "GetSubTreePaths", "sias", "as",
+        [](sd_bus_message* msg, void* context, sd_bus_error* error) {
+            return dispatch(msg, context, error,
+                            &DirectMethods::getSubTreePaths);
+        }),
+    sdbusplus::vtable::method(
+        "GetAssociatedSubTreeById", "ssasass", "a{sa{sas}}",
+        [](sd_bus_message* msg, void* context, sd_bus_error* error) {
+            return dispatch(msg, context, error,
+                            &DirectMethods::getAssociatedSubTreeById);
+        }),
+    sdbusplus::vtable::method(
+        "GetAssociatedSubTreePathsById", "ssasass", "as",
+        [](sd_bus_message* msg, void* context, sd_bus_error* error) {
+            return dispatch(msg, context, error,
+                            &DirectMethods::getAssociatedSubTreePathsById);
+        }),
+    sdbusplus::vtable::end()};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "interface_map.hpp"
+#include "miss_cache.hpp"
+#include "reply_cache.hpp"
+#include "types.hpp"
+
+#include <sdbusplus/message.hpp>
+#include <sdbusplus/vtable.hpp>
+
+/** @brief The mapper methods that reply through sd-bus directly.
+ *
+ * sdbusplus::asio builds a reply from what the handler returns, and an
+ * error reply only from an exception it throws.  These are the methods
+ * clients call most, and asking for a path that isn't there yet is common
+ * while services start, so they send their own replies instead: results
+ * are appended to the reply, and errors set on it without being thrown.
+ * GetSubTree and GetSubTreePaths reply from the reply cache, and
+ * GetObject remembers the paths it didn't find in a miss cache.
+ *
+ * The vtable is added to the mapper object next to the asio interface of
+ * the same name, and sd-bus serves both as one interface.
+ */
+class DirectMethods
+{
+  public:
+    /** @brief Constructor
+     *
+     * @param[in] map          - The interface map the methods read
+     * @param[in] associations - The associations the methods read
+     * @param[in] replies      - The reply cache of the subtree methods
+     * @param[in] misses       - The paths GetObject didn't find
+     */
+    DirectMethods(const InterfaceMapType& map,
+                  const AssociationMaps& associations, ReplyCache& replies,
+                  MissCache& misses);
+
+    /** @brief The methods, with a DirectMethods as context */
+    static const sdbusplus::vtable_t vtable[];
+
+  private:
+    using Method = QueryResult<void> (DirectMethods::*)(sdbusplus::message_t&);
+
+    QueryResult<void> getObject(sdbusplus::message_t& call);
+    QueryResult<void> getAncestors(sdbusplus::message_t& call);
+    QueryResult<void> getSubTree(sdbusplus::message_t& call);
+    QueryResult<void> getSubTreePaths(sdbusplus::message_t& call);
+    QueryResult<void> getAssociatedSubTreeById(sdbusplus::message_t& call);
+    QueryResult<void> getAssociatedSubTreePathsById(sdbusplus::message_t& call);
+
+    static int dispatch(sd_bus_message* msg, void* context,
+                        sd_bus_error* error, Method method);
+
+    const InterfaceMapType& interfaceMap;
+    const AssociationMaps& associationMaps;
+    ReplyCache& replyCache;
+    MissCache& missCache;
+};
@@ -1,49 +1,85 @@
 #include "handler.hpp"
 
+#include "interface_map.hpp"
 #include "path.hpp"
+#include "path_pattern.hpp"
 #include "types.hpp"
 
 #include <xyz/openbmc_project/Common/error.hpp>
 
 #include <algorithm>
 #include <iterator>
+#include <stdexcept>
 #include <string>
-#include <unordered_set>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 void addObjectMapResult(std::vector<InterfaceMapType::value_type>& objectMap,
                         const std::string& objectPath,
-                        const ConnectionNames::value_type& interfaceMap)
+                        ConnectionNames::value_type interfaceMap)
 {
     // Adds an object path/service name/interface list entry to
     // the results of GetSubTree and GetAncestors.
-    // If an entry for the object path already exists, just add the
-    // service name and interfaces to that entry, otherwise create
-    // a new entry.
-    auto entry = std::find_if(
-        objectMap.begin(), objectMap.end(),
-        [&objectPath](const auto& i) { return objectPath == i.first; });
+    // Results are built in object path order, so an existing entry for the
+    // object path can only be the last one.  If there is one, just add the
+    // service name and interfaces to that entry, otherwise create a new
+    // entry.
+    if (objectMap.empty() || objectMap.back().first != objectPath)
+    {
+        objectMap.emplace_back(objectPath, ConnectionNames{});
+    }
+    objectMap.back().second.emplace(std::move(interfaceMap));
+}
 
-    if (entry != objectMap.end())
+const char* errorName(QueryError error)
+{
+    switch (error)
     {
-        entry->second.emplace(interfaceMap);
+        case QueryError::resourceNotFound:
+            return sdbusplus::xyz::openbmc_project::Common::Error::
+                ResourceNotFound::errName;
+        case QueryError::invalidArgument:
+            return sdbusplus::xyz::openbmc_project::Common::Error::
+                InvalidArgument::errName;
     }
-    else
+    return "";
+}
+
+const char* errorDescription(QueryError error)
+{
+    switch (error)
     {
-        InterfaceMapType::value_type object;
-        object.first = objectPath;
-        object.second.emplace(interfaceMap);
-        objectMap.push_back(object);
+        case QueryError::resourceNotFound:
+            return sdbusplus::xyz::openbmc_project::Common::Error::
+                ResourceNotFound::errDesc;
+        case QueryError::invalidArgument:
+            return sdbusplus::xyz::openbmc_project::Common::Error::
+                InvalidArgument::errDesc;
     }
+    return "";
 }
 
-std::vector<InterfaceMapType::value_type> getAncestors(
+void throwQueryError(QueryError error)
+{
+    switch (error)
+    {
+        case QueryError::resourceNotFound:
+            throw sdbusplus::xyz::openbmc_project::Common::Error::
+                ResourceNotFound();
+        case QueryError::invalidArgument:
+            throw sdbusplus::xyz::openbmc_project::Common::Error::
+                InvalidArgument();
+    }
+    throw std::invalid_argument("Unknown query error");
+}
+
+QueryResult<std::vector<InterfaceMapType::value_type>> tryGetAncestors(
     const InterfaceMapType& interfaceMap, std::string reqPath,
     std::vector<std::string>& interfaces)
 {
-    // Interfaces need to be sorted for intersect to function
-    std::sort(interfaces.begin(), interfaces.end());
+    const InterfaceFilter filter(interfaces);
+    const NameTable& names = nameTable();
 
     if (reqPath.ends_with("/"))
     {
@@ -51,42 +87,28 @@ std::vector<InterfaceMapType::value_type> getAncestors(
     }
     if (!reqPath.empty() && !interfaceMap.contains(reqPath))
     {
-        throw sdbusplus::xyz::openbmc_project::Common::Error::
-            ResourceNotFound();
+        return std::unexpected(QueryError::resourceNotFound);
     }
 
     std::vector<InterfaceMapType::value_type> ret;
-    for (const auto& objectPath : interfaceMap)
+    for (const PathNode* ancestor : interfaceMap.findAncestors(reqPath))
     {
-        const auto& thisPath = objectPath.first;
+        const auto& [thisPath, connections] = *ancestor->entry;
 
-        if (reqPath == thisPath)
+        if (filter.empty())
         {
-            continue;
+            ret.emplace_back(thisPath, toConnectionNames(connections));
         }
-
-        if (reqPath.starts_with(thisPath))
+        else
         {
-            if (interfaces.empty())
-            {
-                ret.emplace_back(objectPath);
-            }
-            else
+            for (const auto& [connection, connectionInterfaces] : connections)
             {
-                for (const auto& connectionInterfaces : objectPath.second)
+                if (filter.intersects(connectionInterfaces))
                 {
-                    std::vector<std::string> output(std::min(
-                        interfaces.size(), connectionInterfaces.second.size()));
-                    // Return iterator points at the first output elemtn,
-                    // meaning that there are no intersections.
-                    if (std::set_intersection(
-                            interfaces.begin(), interfaces.end(),
-                            connectionInterfaces.second.begin(),
-                            connectionInterfaces.second.end(),
-                            output.begin()) != output.begin())
-                    {
-                        addObjectMapResult(ret, thisPath, connectionInterfaces);
-                    }
+                    addObjectMapResult(
+                        ret, thisPath,
+                        {names[connection],
+                         toInterfaceNames(connectionInterfaces)});
                 }
             }
         }
@@ -95,115 +117,204 @@ std::vector<InterfaceMapType::value_type> getAncestors(
     return ret;
 }
 
-ConnectionNames getObject(const InterfaceMapType& interfaceMap,
-                          const std::string& path,
-                          std::vector<std::string>& interfaces)
+std::vector<InterfaceMapType::value_type> getAncestors(
+    const InterfaceMapType& interfaceMap, std::string reqPath,
+    std::vector<std::string>& interfaces)
+{
+    return valueOrThrow(
+        tryGetAncestors(interfaceMap, std::move(reqPath), interfaces));
+}
+
+QueryResult<ConnectionNames> tryGetObject(const InterfaceMapType& interfaceMap,
+                                          const std::string& path,
+                                          std::vector<std::string>& interfaces)
 {
     ConnectionNames results;
 
-    // Interfaces need to be sorted for intersect to function
-    std::sort(interfaces.begin(), interfaces.end());
+    const InterfaceFilter filter(interfaces);
     auto pathRef = interfaceMap.find(path);
     if (pathRef == interfaceMap.end())
     {
-        throw sdbusplus::xyz::openbmc_project::Common::Error::
-            ResourceNotFound();
+        return std::unexpected(QueryError::resourceNotFound);
     }
-    if (interfaces.empty())
+    if (filter.empty())
     {
-        return pathRef->second;
+        return toConnectionNames(pathRef->second);
     }
-    for (const auto& connectionInterfaces : pathRef->second)
+    const NameTable& names = nameTable();
+    for (const auto& [connection, connectionInterfaces] : pathRef->second)
     {
-        std::vector<std::string> output(
-            std::min(interfaces.size(), connectionInterfaces.second.size()));
-        // Return iterator points at the first output elemtn,
-        // meaning that there are no intersections.
-        if (std::set_intersection(interfaces.begin(), interfaces.end(),
-                                  connectionInterfaces.second.begin(),
-                                  connectionInterfaces.second.end(),
-                                  output.begin()) != output.begin())
+        if (filter.intersects(connectionInterfaces))
         {
-            results.emplace(connectionInterfaces.first,
-                            connectionInterfaces.second);
+            results.emplace(names[connection],
+                            toInterfaceNames(connectionInterfaces));
         }
     }
 
     if (results.empty())
     {
-        throw sdbusplus::xyz::openbmc_project::Common::Error::
-            ResourceNotFound();
+        return std::unexpected(QueryError::resourceNotFound);
     }
 
     return results;
 }
 
-std::vector<InterfaceMapType::value_type> getSubTree(
-    const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
-    std::vector<std::string>& interfaces)
+QueryResult<ConnectionNames> tryGetObject(const InterfaceMapType& interfaceMap,
+                                          MissCache& missCache,
+                                          const std::string& path,
+                                          std::vector<std::string>& interfaces)
+{
+    if (missCache.contains(path))
+    {
+        return std::unexpected(QueryError::resourceNotFound);
+    }
+    auto result = tryGetObject(interfaceMap, path, interfaces);
+    if (!result && !interfaceMap.contains(path))
+    {
+        missCache.insert(path);
+    }
+    return result;
+}
+
+ConnectionNames getObject(const InterfaceMapType& interfaceMap,
+                          const std::string& path,
+                          std::vector<std::string>& interfaces)
+{
+    return valueOrThrow(tryGetObject(interfaceMap, path, interfaces));
+}
+
+// The part of the interface map a subtree query covers
+struct SubTreeRoot
+{
+    // The requested path, without a trailing "/"
+    std::string_view path;
+    const PathNode* node;
+    int32_t depth;
+};
+
+static QueryResult<SubTreeRoot> findSubTreeRoot(
+    const InterfaceMapType& interfaceMap, std::string_view reqPath,
+    int32_t depth)
 {
     if (depth <= 0)
     {
         depth = std::numeric_limits<int32_t>::max();
     }
-    // Interfaces need to be sorted for intersect to function
-    std::sort(interfaces.begin(), interfaces.end());
 
-    // reqPath is now guaranteed to have a trailing "/" while reqPathStripped
-    // will be guaranteed not to have a trailing "/"
-    if (!reqPath.ends_with("/"))
+    if (reqPath.ends_with("/"))
     {
-        reqPath += "/";
+        reqPath.remove_suffix(1);
     }
-    std::string_view reqPathStripped =
-        std::string_view(reqPath).substr(0, reqPath.size() - 1);
 
-    if (!reqPathStripped.empty() &&
-        interfaceMap.find(reqPathStripped) == interfaceMap.end())
+    const PathNode* reqNode = interfaceMap.findNode(reqPath);
+    if (!reqPath.empty() && (reqNode == nullptr || reqNode->entry == nullptr))
     {
-        throw sdbusplus::xyz::openbmc_project::Common::Error::
-            ResourceNotFound();
+        return std::unexpected(QueryError::resourceNotFound);
     }
+    return SubTreeRoot{reqPath, reqNode, depth};
+}
 
-    std::vector<InterfaceMapType::value_type> ret;
-    for (const auto& objectPath : interfaceMap)
+// Check if a path is below the root of a subtree query, within its depth
+static bool inSubTree(const SubTreeRoot& root, std::string_view path)
+{
+    if (path.size() <= root.path.size() || !path.starts_with(root.path) ||
+        path[root.path.size()] != '/')
     {
-        const auto& thisPath = objectPath.first;
+        return false;
+    }
+    path.remove_prefix(root.path.size());
+    return std::count(path.begin(), path.end(), '/') <= root.depth;
+}
 
-        // Skip exact match on stripped search term
-        if (thisPath == reqPathStripped)
+// Add a result entry for a path with the connections on it that match the
+// filter, if there are any.  The entry is always a new one, even if the
+// previous result is for the same path.
+static void addSubTreeResult(
+    std::vector<InterfaceMapType::value_type>& ret,
+    const InterfaceMapType::PathMap::value_type& objectPath,
+    const InterfaceFilter& filter)
+{
+    const NameTable& names = nameTable();
+    ConnectionNames connections;
+    for (const auto& [connection, connectionInterfaces] : objectPath.second)
+    {
+        if (filter.matches(connectionInterfaces))
         {
-            continue;
+            connections.emplace(names[connection],
+                                toInterfaceNames(connectionInterfaces));
         }
+    }
+    if (!connections.empty())
+    {
+        ret.emplace_back(objectPath.first, std::move(connections));
+    }
+}
 
-        if (thisPath.starts_with(reqPath))
-        {
-            // count the number of slashes past the stripped search term
-            auto thisDepth = std::count(
-                thisPath.begin() + std::distance(reqPathStripped.begin(),
-                                                 reqPathStripped.end()),
-                thisPath.end(), '/');
-            if (thisDepth <= depth)
+// Check if any connection on a path matches the filter
+static bool matchesAny(const ConnectionIds& connections,
+                       const InterfaceFilter& filter)
+{
+    if (filter.empty())
+    {
+        return true;
+    }
+    return std::any_of(connections.begin(), connections.end(),
+                       [&filter](const auto& connectionInterfaces) {
+                           return filter.intersects(
+                               connectionInterfaces.second);
+                       });
+}
+
+QueryResult<std::vector<InterfaceMapType::value_type>> tryGetSubTree(
+    const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
+    std::vector<std::string>& interfaces)
+{
+    const auto root = findSubTreeRoot(interfaceMap, reqPath, depth);
+    if (!root)
+    {
+        return std::unexpected(root.error());
+    }
+    const InterfaceFilter filter(interfaces);
+
+    std::vector<InterfaceMapType::value_type> ret;
+    interfaceMap.forEachDescendant(
+        *root->node, root->path, root->depth, filter,
+        [&filter, &ret](const auto& objectPath) {
+            addSubTreeResult(ret, objectPath, filter);
+        });
+
+    return ret;
+}
+
+std::vector<InterfaceMapType::value_type> getSubTree(
+    const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
+    std::vector<std::string>& interfaces)
+{
+    return valueOrThrow(
+        tryGetSubTree(interfaceMap, std::move(reqPath), depth, interfaces));
+}
+
+QueryResult<std::vector<std::string>> tryGetSubTreePaths(
+    const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
+    std::vector<std::string>& interfaces)
+{
+    const auto root = findSubTreeRoot(interfaceMap, reqPath, depth);
+    if (!root)
+    {
+        return std::unexpected(root.error());
+    }
+    const InterfaceFilter filter(interfaces);
+
+    std::vector<std::string> ret;
+    interfaceMap.forEachDescendant(
+        *root->node, root->path, root->depth, filter,
+        [&filter, &ret](const auto& objectPath) {
+            if (matchesAny(objectPath.second, filter))
             {
-                for (const auto& connectionInterfaces : objectPath.second)
-                {
-                    std::vector<std::string> output(std::min(
-                        interfaces.size(), connectionInterfaces.second.size()));
-                    // Return iterator points at the first output elemtn,
-                    // meaning that there are no intersections.
-                    if (std::set_intersection(
-                            interfaces.begin(), interfaces.end(),
-                            connectionInterfaces.second.begin(),
-                            connectionInterfaces.second.end(),
-                            output.begin()) != output.begin() ||
-                        interfaces.empty())
-                    {
-                        addObjectMapResult(ret, thisPath, connectionInterfaces);
-                    }
-                }
+                // TODO(ed) this is a copy
+                ret.emplace_back(objectPath.first);
             }
-        }
-    }
+        });
 
     return ret;
 }
@@ -212,109 +323,370 @@ std::vector<std::string> getSubTreePaths(const InterfaceMapType& interfaceMap,
                                          std::string reqPath, int32_t depth,
                                          std::vector<std::string>& interfaces)
 {
-    if (depth <= 0)
+    return valueOrThrow(tryGetSubTreePaths(interfaceMap, std::move(reqPath),
+                                           depth, interfaces));
+}
+
+ServiceObjects getObjectsByService(const InterfaceMapType& interfaceMap,
+                                   const std::string& service,
+                                   std::vector<std::string>& interfaces)
+{
+    ServiceObjects ret;
+    const InterfaceMapType::PathSet* owned =
+        interfaceMap.findConnection(service);
+    if (owned == nullptr)
     {
-        depth = std::numeric_limits<int32_t>::max();
+        return ret;
     }
-    // Interfaces need to be sorted for intersect to function
-    std::sort(interfaces.begin(), interfaces.end());
-
-    // reqPath is now guaranteed to have a trailing "/" while reqPathStripped
-    // will be guaranteed not to have a trailing "/"
-    if (!reqPath.ends_with("/"))
+    const InterfaceFilter filter(interfaces);
+    if (filter.empty())
     {
-        reqPath += "/";
+        ret.reserve(owned->size());
     }
-    std::string_view reqPathStripped =
-        std::string_view(reqPath).substr(0, reqPath.size() - 1);
 
-    if (!reqPathStripped.empty() &&
-        interfaceMap.find(reqPathStripped) == interfaceMap.end())
+    // The service is in the name table since it is on some paths
+    const NameId connection = *nameTable().find(service);
+    for (const PathNode* node : *owned)
     {
-        throw sdbusplus::xyz::openbmc_project::Common::Error::
-            ResourceNotFound();
+        const InterfaceIds& serviceInterfaces =
+            node->entry->second.find(connection)->second;
+        if (filter.matches(serviceInterfaces))
+        {
+            ret.emplace_back(node->entry->first,
+                             toInterfaceNames(serviceInterfaces));
+        }
     }
+    return ret;
+}
 
-    std::vector<std::string> ret;
-    for (const auto& objectPath : interfaceMap)
+// Call fn with the entry of every node below node that matches the
+// pattern segments from segment on, in path order
+template <typename Fn>
+static void forEachPatternMatch(const PathNode& node,
+                                const std::vector<PathPattern::Segment>& parts,
+                                size_t segment, Fn&& fn)
+{
+    const PathPattern::Segment& part = parts[segment];
+    auto visit = [&](const PathNode& child) {
+        if (segment + 1 < parts.size())
+        {
+            forEachPatternMatch(child, parts, segment + 1, fn);
+        }
+        else if (child.entry != nullptr)
+        {
+            fn(*child.entry);
+        }
+    };
+
+    if (part.literal())
     {
-        const auto& thisPath = objectPath.first;
+        auto child = node.children.find(part.glob);
+        if (child != node.children.end())
+        {
+            visit(*child->second);
+        }
+        return;
+    }
 
-        // Skip exact match on stripped search term
-        if (thisPath == reqPathStripped)
+    // Only the children that start with the literal prefix can match
+    const std::string_view prefix = part.prefix();
+    for (auto child = node.children.lower_bound(prefix);
+         child != node.children.end() && child->first.starts_with(prefix);
+         ++child)
+    {
+        if (part.matches(child->first))
         {
-            continue;
+            visit(*child->second);
         }
+    }
+}
 
-        if (thisPath.starts_with(reqPath))
+QueryResult<std::vector<InterfaceMapType::value_type>> tryGetSubTreeByPattern(
+    const InterfaceMapType& interfaceMap, const std::string& pattern,
+    std::vector<std::string>& interfaces)
+{
+    auto compiled = PathPattern::compile(pattern);
+    if (!compiled)
+    {
+        return std::unexpected(compiled.error());
+    }
+    const InterfaceFilter filter(interfaces);
+
+    std::vector<InterfaceMapType::value_type> ret;
+    forEachPatternMatch(*interfaceMap.findNode(""), compiled->segments(), 0,
+                        [&filter, &ret](const auto& objectPath) {
+                            addSubTreeResult(ret, objectPath, filter);
+                        });
+    return ret;
+}
+
+std::vector<InterfaceMapType::value_type> getSubTreeByPattern(
+    const InterfaceMapType& interfaceMap, const std::string& pattern,
+    std::vector<std::string>& interfaces)
+{
+    return valueOrThrow(
+        tryGetSubTreeByPattern(interfaceMap, pattern, interfaces));
+}
+
+// The name list of a compact subtree, with each name added once
+class CompactNames
+{
+  public:
+    uint32_t index(NameId id)
+    {
+        auto [it, added] =
+            indexes.emplace(id, static_cast<uint32_t>(names.size()));
+        if (added)
         {
-            // count the number of slashes past the stripped search term
-            auto thisDepth = std::count(
-                thisPath.begin() + std::distance(reqPathStripped.begin(),
-                                                 reqPathStripped.end()),
-                thisPath.end(), '/');
-            if (thisDepth <= depth)
+            names.emplace_back(nameTable()[id]);
+        }
+        return it->second;
+    }
+
+    std::vector<std::string> names;
+
+  private:
+    boost::container::flat_map<NameId, uint32_t> indexes;
+};
+
+QueryResult<CompactSubTree> tryGetSubTreeCompact(
+    const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
+    std::vector<std::string>& interfaces, uint32_t projection)
+{
+    if (projection > static_cast<uint32_t>(SubTreeProjection::interfaces))
+    {
+        return std::unexpected(QueryError::invalidArgument);
+    }
+    const auto shape = static_cast<SubTreeProjection>(projection);
+
+    const auto root = findSubTreeRoot(interfaceMap, reqPath, depth);
+    if (!root)
+    {
+        return std::unexpected(root.error());
+    }
+    const InterfaceFilter filter(interfaces);
+
+    CompactNames names;
+    std::vector<CompactObject> objects;
+    interfaceMap.forEachDescendant(
+        *root->node, root->path, root->depth, filter,
+        [&filter, &names, &objects, shape](const auto& objectPath) {
+            if (!matchesAny(objectPath.second, filter))
+            {
+                return;
+            }
+            auto& [path, connections] = objects.emplace_back(
+                objectPath.first, std::vector<CompactConnection>());
+            if (shape == SubTreeProjection::paths)
+            {
+                return;
+            }
+
+            for (const auto& [connection, connectionInterfaces] :
+                 objectPath.second)
             {
-                bool add = interfaces.empty();
-                for (const auto& connectionInterfaces : objectPath.second)
+                if (!filter.matches(connectionInterfaces))
                 {
-                    std::vector<std::string> output(std::min(
-                        interfaces.size(), connectionInterfaces.second.size()));
-                    // Return iterator points at the first output elemtn,
-                    // meaning that there are no intersections.
-                    if (std::set_intersection(
-                            interfaces.begin(), interfaces.end(),
-                            connectionInterfaces.second.begin(),
-                            connectionInterfaces.second.end(),
-                            output.begin()) != output.begin())
-                    {
-                        add = true;
-                        break;
-                    }
+                    continue;
                 }
-                if (add)
+                auto& [name, interfaceIndexes] = connections.emplace_back(
+                    names.index(connection), std::vector<uint32_t>());
+                for (NameId interface : connectionInterfaces)
                 {
-                    // TODO(ed) this is a copy
-                    ret.emplace_back(thisPath);
+                    if (shape == SubTreeProjection::interfaces ||
+                        (shape == SubTreeProjection::matchedInterfaces &&
+                         (filter.empty() ||
+                          std::binary_search(filter.ids().begin(),
+                                             filter.ids().end(), interface))))
+                    {
+                        interfaceIndexes.emplace_back(names.index(interface));
+                    }
                 }
             }
-        }
+        });
+
+    return CompactSubTree(std::move(names.names), std::move(objects));
+}
+
+CompactSubTree getSubTreeCompact(const InterfaceMapType& interfaceMap,
+                                 std::string reqPath, int32_t depth,
+                                 std::vector<std::string>& interfaces,
+                                 uint32_t projection)
+{
+    return valueOrThrow(tryGetSubTreeCompact(interfaceMap, std::move(reqPath),
+                                             depth, interfaces, projection));
+}
+
+// Find a page of a subtree query, and set next to the token of the page
+// after it if there is one.  The token is the last path of the page.
+static QueryResult<std::vector<const PathNode*>> findSubTreePage(
+    const InterfaceMapType& interfaceMap, const SubTreeRoot& root,
+    const InterfaceFilter& filter, uint32_t pageSize, const std::string& token,
+    std::string& next)
+{
+    if (!token.empty() && !inSubTree(root, token))
+    {
+        return std::unexpected(QueryError::invalidArgument);
     }
 
-    return ret;
+    size_t limit = pageSize == 0 ? maxSubTreePageSize
+                                 : std::min(pageSize, maxSubTreePageSize);
+
+    // Ask for one more to know if this is the last page
+    std::vector<const PathNode*> page = interfaceMap.findDescendants(
+        *root.node, root.path, root.depth, filter, token, limit + 1);
+    if (page.size() > limit)
+    {
+        page.pop_back();
+        next = page.back()->entry->first;
+    }
+    return page;
 }
 
-std::vector<InterfaceMapType::value_type> getAssociatedSubTree(
+QueryResult<std::tuple<std::vector<InterfaceMapType::value_type>, std::string>>
+    tryGetSubTreePage(const InterfaceMapType& interfaceMap, std::string reqPath,
+                      int32_t depth, std::vector<std::string>& interfaces,
+                      uint32_t pageSize, const std::string& token)
+{
+    const auto root = findSubTreeRoot(interfaceMap, reqPath, depth);
+    if (!root)
+    {
+        return std::unexpected(root.error());
+    }
+    const InterfaceFilter filter(interfaces);
+
+    std::string next;
+    const auto page =
+        findSubTreePage(interfaceMap, *root, filter, pageSize, token, next);
+    if (!page)
+    {
+        return std::unexpected(page.error());
+    }
+
+    std::vector<InterfaceMapType::value_type> ret;
+    for (const PathNode* node : *page)
+    {
+        addSubTreeResult(ret, *node->entry, filter);
+    }
+
+    return std::make_tuple(std::move(ret), std::move(next));
+}
+
+std::tuple<std::vector<InterfaceMapType::value_type>, std::string>
+    getSubTreePage(const InterfaceMapType& interfaceMap, std::string reqPath,
+                   int32_t depth, std::vector<std::string>& interfaces,
+                   uint32_t pageSize, const std::string& token)
+{
+    return valueOrThrow(tryGetSubTreePage(interfaceMap, std::move(reqPath),
+                                          depth, interfaces, pageSize, token));
+}
+
+QueryResult<std::tuple<std::vector<std::string>, std::string>>
+    tryGetSubTreePathsPage(const InterfaceMapType& interfaceMap,
+                           std::string reqPath, int32_t depth,
+                           std::vector<std::string>& interfaces,
+                           uint32_t pageSize, const std::string& token)
+{
+    const auto root = findSubTreeRoot(interfaceMap, reqPath, depth);
+    if (!root)
+    {
+        return std::unexpected(root.error());
+    }
+    const InterfaceFilter filter(interfaces);
+
+    std::string next;
+    const auto page =
+        findSubTreePage(interfaceMap, *root, filter, pageSize, token, next);
+    if (!page)
+    {
+        return std::unexpected(page.error());
+    }
+
+    std::vector<std::string> ret;
+    for (const PathNode* node : *page)
+    {
+        ret.emplace_back(node->entry->first);
+    }
+
+    return std::make_tuple(std::move(ret), std::move(next));
+}
+
+std::tuple<std::vector<std::string>, std::string> getSubTreePathsPage(
+    const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
+    std::vector<std::string>& interfaces, uint32_t pageSize,
+    const std::string& token)
+{
+    return valueOrThrow(
+        tryGetSubTreePathsPage(interfaceMap, std::move(reqPath), depth,
+                               interfaces, pageSize, token));
+}
+
+// Call fn with each endpoint of an association that is in the interface
+// map and below the root of a subtree query, in path order
+template <typename Fn>
+static void forEachEndpointInSubTree(
     const InterfaceMapType& interfaceMap,
-    const AssociationMaps& associationMaps,
-    const sdbusplus::message::object_path& associationPath,
-    const sdbusplus::message::object_path& reqPath, int32_t depth,
-    std::vector<std::string>& interfaces)
+    const AssociationInterfaces::mapped_type& association,
+    const SubTreeRoot& root, Fn&& fn)
+{
+    const Endpoints& endpoints = std::get<endpointsPos>(association);
+    const EndpointLookup& lookup = std::get<endpointLookupPos>(association);
+    for (uint32_t index : lookup.sorted(endpoints))
+    {
+        const std::string& endpoint = endpoints[index];
+        if (!inSubTree(root, endpoint))
+        {
+            continue;
+        }
+        auto objectPath = interfaceMap.find(endpoint);
+        if (objectPath != interfaceMap.end())
+        {
+            fn(*objectPath);
+        }
+    }
+}
+
+QueryResult<std::vector<InterfaceMapType::value_type>>
+    tryGetAssociatedSubTree(
+        const InterfaceMapType& interfaceMap,
+        const AssociationMaps& associationMaps,
+        const sdbusplus::message::object_path& associationPath,
+        const sdbusplus::message::object_path& reqPath, int32_t depth,
+        std::vector<std::string>& interfaces)
 {
     auto findEndpoint = associationMaps.ifaces.find(associationPath.str);
     if (findEndpoint == associationMaps.ifaces.end())
     {
         return {};
     }
-    const std::vector<std::string>& association =
-        std::get<endpointsPos>(findEndpoint->second);
-    std::unordered_set<std::string> associationSet(association.begin(),
-                                                   association.end());
-    const std::vector<InterfaceMapType::value_type> interfacePairs =
-        getSubTree(interfaceMap, reqPath, depth, interfaces);
-
-    std::vector<InterfaceMapType::value_type> output;
-    for (const InterfaceMapType::value_type& interfacePair : interfacePairs)
+    const auto root = findSubTreeRoot(interfaceMap, reqPath.str, depth);
+    if (!root)
     {
-        if (associationSet.contains(interfacePair.first))
-        {
-            output.emplace_back(interfacePair);
-        }
+        return std::unexpected(root.error());
     }
+    const InterfaceFilter filter(interfaces);
+
+    std::vector<InterfaceMapType::value_type> output;
+    forEachEndpointInSubTree(interfaceMap, findEndpoint->second, *root,
+                             [&filter, &output](const auto& objectPath) {
+                                 addSubTreeResult(output, objectPath, filter);
+                             });
     return output;
 }
 
-std::vector<std::string> getAssociatedSubTreePaths(
+std::vector<InterfaceMapType::value_type> getAssociatedSubTree(
+    const InterfaceMapType& interfaceMap,
+    const AssociationMaps& associationMaps,
+    const sdbusplus::message::object_path& associationPath,
+    const sdbusplus::message::object_path& reqPath, int32_t depth,
+    std::vector<std::string>& interfaces)
+{
+    return valueOrThrow(tryGetAssociatedSubTree(interfaceMap, associationMaps,
+                                                associationPath, reqPath,
+                                                depth, interfaces));
+}
+
+QueryResult<std::vector<std::string>> tryGetAssociatedSubTreePaths(
     const InterfaceMapType& interfaceMap,
     const AssociationMaps& associationMaps,
     const sdbusplus::message::object_path& associationPath,
@@ -326,31 +698,45 @@ std::vector<std::string> getAssociatedSubTreePaths(
     {
         return {};
     }
-    const std::vector<std::string>& association =
-        std::get<endpointsPos>(findEndpoint->second);
-    std::unordered_set<std::string> associationSet(association.begin(),
-                                                   association.end());
-    const std::vector<std::string> paths =
-        getSubTreePaths(interfaceMap, reqPath, depth, interfaces);
-
-    std::vector<std::string> output;
-    for (const auto& path : paths)
+    const auto root = findSubTreeRoot(interfaceMap, reqPath.str, depth);
+    if (!root)
     {
-        if (associationSet.contains(path))
-        {
-            output.emplace_back(path);
-        }
+        return std::unexpected(root.error());
     }
+    const InterfaceFilter filter(interfaces);
+
+    std::vector<std::string> output;
+    forEachEndpointInSubTree(interfaceMap, findEndpoint->second, *root,
+                             [&filter, &output](const auto& objectPath) {
+                                 if (matchesAny(objectPath.second, filter))
+                                 {
+                                     output.emplace_back(objectPath.first);
+                                 }
+                             });
     return output;
 }
 
+std::vector<std::string> getAssociatedSubTreePaths(
+    const InterfaceMapType& interfaceMap,
+    const AssociationMaps& associationMaps,
+    const sdbusplus::message::object_path& associationPath,
+    const sdbusplus::message::object_path& reqPath, int32_t depth,
+    std::vector<std::string>& interfaces)
+{
+    return valueOrThrow(tryGetAssociatedSubTreePaths(
+        interfaceMap, associationMaps, associationPath, reqPath, depth,
+        interfaces));
+}
+
 // This function works like getSubTreePaths() but only matching id with
-// the leaf-name instead of full path.
-static std::vector<std::string> getSubTreePathsById(
-    const InterfaceMapType& interfaceMap, const std::string& id,
-    const std::string& objectPath, std::vector<std::string>& interfaces)
+// the leaf-name instead of full path.  The matching interface map entries
+// are returned in path order.
+static QueryResult<std::vector<const InterfaceMapType::PathMap::value_type*>>
+    getSubTreePathsById(const InterfaceMapType& interfaceMap,
+                        const std::string& id, const std::string& objectPath,
+                        std::vector<std::string>& interfaces)
 {
-    std::sort(interfaces.begin(), interfaces.end());
+    const InterfaceFilter filter(interfaces);
 
     std::string localObjectPath = objectPath;
 
@@ -364,18 +750,27 @@ static std::vector<std::string> getSubTreePathsById(
     if (!objectPathStripped.empty() &&
         interfaceMap.find(objectPathStripped) == interfaceMap.end())
     {
-        throw sdbusplus::xyz::openbmc_project::Common::Error::
-            ResourceNotFound();
+        return std::unexpected(QueryError::resourceNotFound);
+    }
+
+    // Only the paths ending in the last segment of the id can match it
+    std::string_view leaf = id;
+    size_t leafPos = leaf.rfind('/');
+    if (leafPos != std::string_view::npos)
+    {
+        leaf.remove_prefix(leafPos + 1);
     }
+    const std::string idSuffix = "/" + id;
 
     bool validId = false;
-    std::vector<std::string> output;
-    for (const auto& path : interfaceMap)
+    std::vector<const InterfaceMapType::PathMap::value_type*> output;
+    for (const PathNode* node : interfaceMap.findLeaf(leaf))
     {
-        const auto& thisPath = path.first;
+        const auto& path = *node->entry;
+        const std::string& thisPath = path.first;
 
         // Skip the path does not end with the id
-        if (!thisPath.ends_with("/" + id))
+        if (!thisPath.ends_with(idSuffix))
         {
             continue;
         }
@@ -392,15 +787,9 @@ static std::vector<std::string> getSubTreePathsById(
         {
             for (const auto& connectionInterfaces : path.second)
             {
-                std::vector<std::string> tempoutput(std::min(
-                    interfaces.size(), connectionInterfaces.second.size()));
-                if (std::set_intersection(interfaces.begin(), interfaces.end(),
-                                          connectionInterfaces.second.begin(),
-                                          connectionInterfaces.second.end(),
-                                          tempoutput.begin()) !=
-                    tempoutput.begin())
+                if (filter.intersects(connectionInterfaces.second))
                 {
-                    output.emplace_back(thisPath);
+                    output.emplace_back(&path);
                     break;
                 }
             }
@@ -408,36 +797,108 @@ static std::vector<std::string> getSubTreePathsById(
     }
     if (!validId)
     {
-        throw sdbusplus::xyz::openbmc_project::Common::Error::
-            ResourceNotFound();
+        return std::unexpected(QueryError::resourceNotFound);
     }
     return output;
 }
 
-std::vector<InterfaceMapType::value_type> getAssociatedSubTreeById(
+// Call fn with the endpoints below objectPath of the association of every
+// path getSubTreePathsById() finds.  The endpoints are visited per id path
+// in path order, the same as concatenating getAssociatedSubTree() for
+// each of them, but the subtree root is only looked up once.
+template <typename Fn>
+static QueryResult<void> forEachAssociatedById(
     const InterfaceMapType& interfaceMap,
     const AssociationMaps& associationMaps, const std::string& id,
     const std::string& objectPath, std::vector<std::string>& subtreeInterfaces,
-    const std::string& association,
-    std::vector<std::string>& endpointInterfaces)
+    const std::string& association, Fn&& fn)
 {
-    std::vector<std::string> subtreePaths =
+    const auto idPaths =
         getSubTreePathsById(interfaceMap, id, objectPath, subtreeInterfaces);
+    if (!idPaths)
+    {
+        return std::unexpected(idPaths.error());
+    }
+    if (idPaths->empty())
+    {
+        return {};
+    }
+    const auto root = findSubTreeRoot(interfaceMap, objectPath, 0);
+    if (!root)
+    {
+        return std::unexpected(root.error());
+    }
+
+    for (const auto* idPath : *idPaths)
+    {
+        auto findEndpoint = associationMaps.ifaces.find(
+            appendPathSegment(idPath->first, association));
+        if (findEndpoint != associationMaps.ifaces.end())
+        {
+            forEachEndpointInSubTree(interfaceMap, findEndpoint->second, *root,
+                                     fn);
+        }
+    }
+    return {};
+}
+
+QueryResult<std::vector<InterfaceMapType::value_type>>
+    tryGetAssociatedSubTreeById(
+        const InterfaceMapType& interfaceMap,
+        const AssociationMaps& associationMaps, const std::string& id,
+        const std::string& objectPath,
+        std::vector<std::string>& subtreeInterfaces,
+        const std::string& association,
+        std::vector<std::string>& endpointInterfaces)
+{
+    const InterfaceFilter filter(endpointInterfaces);
 
     std::vector<InterfaceMapType::value_type> output;
-    for (const auto& subtreePath : subtreePaths)
+    auto found = forEachAssociatedById(
+        interfaceMap, associationMaps, id, objectPath, subtreeInterfaces,
+        association, [&filter, &output](const auto& endpoint) {
+            addSubTreeResult(output, endpoint, filter);
+        });
+    if (!found)
     {
-        // Form the association path
-        std::string associationPathStr =
-            appendPathSegment(subtreePath, association);
-        sdbusplus::message::object_path associationPath(associationPathStr);
+        return std::unexpected(found.error());
+    }
+    return output;
+}
 
-        auto associatedSubTree =
-            getAssociatedSubTree(interfaceMap, associationMaps, associationPath,
-                                 objectPath, 0, endpointInterfaces);
+std::vector<InterfaceMapType::value_type> getAssociatedSubTreeById(
+    const InterfaceMapType& interfaceMap,
+    const AssociationMaps& associationMaps, const std::string& id,
+    const std::string& objectPath, std::vector<std::string>& subtreeInterfaces,
+    const std::string& association,
+    std::vector<std::string>& endpointInterfaces)
+{
+    return valueOrThrow(tryGetAssociatedSubTreeById(
+        interfaceMap, associationMaps, id, objectPath, subtreeInterfaces,
+        association, endpointInterfaces));
+}
+
+QueryResult<std::vector<std::string>> tryGetAssociatedSubTreePathsById(
+    const InterfaceMapType& interfaceMap,
+    const AssociationMaps& associationMaps, const std::string& id,
+    const std::string& objectPath, std::vector<std::string>& subtreeInterfaces,
+    const std::string& association,
+    std::vector<std::string>& endpointInterfaces)
+{
+    const InterfaceFilter filter(endpointInterfaces);
 
-        output.insert(output.end(), associatedSubTree.begin(),
-                      associatedSubTree.end());
+    std::vector<std::string> output;
+    auto found = forEachAssociatedById(
+        interfaceMap, associationMaps, id, objectPath, subtreeInterfaces,
+        association, [&filter, &output](const auto& endpoint) {
+            if (matchesAny(endpoint.second, filter))
+            {
+                output.emplace_back(endpoint.first);
+            }
+        });
+    if (!found)
+    {
+        return std::unexpected(found.error());
     }
     return output;
 }
@@ -449,23 +910,158 @@ std::vector<std::string> getAssociatedSubTreePathsById(
     const std::string& association,
     std::vector<std::string>& endpointInterfaces)
 {
-    std::vector<std::string> subtreePaths =
-        getSubTreePathsById(interfaceMap, id, objectPath, subtreeInterfaces);
-    std::vector<std::string> output;
-    for (const auto& subtreePath : subtreePaths)
+    return valueOrThrow(tryGetAssociatedSubTreePathsById(
+        interfaceMap, associationMaps, id, objectPath, subtreeInterfaces,
+        association, endpointInterfaces));
+}
+
+// Get an argument of a batched query.  Arguments that aren't required are
+// left alone if they are missing.  Returns false if a required argument is
+// missing or the argument has the wrong type.
+template <typename T>
+static bool batchArgument(const BatchArguments& arguments,
+                          const std::string& name, T& value,
+                          bool required = true)
+{
+    auto argument = arguments.find(name);
+    if (argument == arguments.end())
     {
-        // Form the association path
-        std::string associationPathStr =
-            appendPathSegment(subtreePath, association);
-        sdbusplus::message::object_path associationPath(associationPathStr);
+        return !required;
+    }
+    const T* found = std::get_if<T>(&argument->second);
+    if (found == nullptr)
+    {
+        return false;
+    }
+    value = *found;
+    return true;
+}
 
-        auto associatedSubTree = getAssociatedSubTreePaths(
-            interfaceMap, associationMaps, associationPath, objectPath, 0,
-            endpointInterfaces);
+template <typename T>
+static QueryResult<BatchValue> toBatchValue(QueryResult<T>&& result)
+{
+    if (!result)
+    {
+        return std::unexpected(result.error());
+    }
+    return BatchValue(std::move(*result));
+}
 
-        output.insert(output.end(), associatedSubTree.begin(),
-                      associatedSubTree.end());
+static QueryResult<BatchValue> runBatchQuery(
+    const InterfaceMapType& interfaceMap,
+    const AssociationMaps& associationMaps, MissCache& missCache,
+    const BatchQuery& query)
+{
+    const auto& [method, arguments] = query;
+    std::string path;
+    std::vector<std::string> interfaces;
+    if (!batchArgument(arguments, "path", path) ||
+        !batchArgument(arguments, "interfaces", interfaces, false))
+    {
+        return std::unexpected(QueryError::invalidArgument);
     }
 
-    return output;
+    if (method == "GetObject")
+    {
+        return toBatchValue(
+            tryGetObject(interfaceMap, missCache, path, interfaces));
+    }
+    if (method == "GetAncestors")
+    {
+        return toBatchValue(tryGetAncestors(interfaceMap, path, interfaces));
+    }
+    if (method == "GetSubTreeByPattern")
+    {
+        return toBatchValue(
+            tryGetSubTreeByPattern(interfaceMap, path, interfaces));
+    }
+
+    if (method.ends_with("ById"))
+    {
+        std::string id;
+        std::string association;
+        std::vector<std::string> endpointInterfaces;
+        if (!batchArgument(arguments, "id", id) ||
+            !batchArgument(arguments, "association", association) ||
+            !batchArgument(arguments, "endpointInterfaces", endpointInterfaces,
+                           false))
+        {
+            return std::unexpected(QueryError::invalidArgument);
+        }
+        if (method == "GetAssociatedSubTreeById")
+        {
+            return toBatchValue(tryGetAssociatedSubTreeById(
+                interfaceMap, associationMaps, id, path, interfaces,
+                association, endpointInterfaces));
+        }
+        if (method == "GetAssociatedSubTreePathsById")
+        {
+            return toBatchValue(tryGetAssociatedSubTreePathsById(
+                interfaceMap, associationMaps, id, path, interfaces,
+                association, endpointInterfaces));
+        }
+        return std::unexpected(QueryError::invalidArgument);
+    }
+
+    int32_t depth = 0;
+    if (!batchArgument(arguments, "depth", depth, false))
+    {
+        return std::unexpected(QueryError::invalidArgument);
+    }
+    if (method == "GetSubTree")
+    {
+        return toBatchValue(
+            tryGetSubTree(interfaceMap, path, depth, interfaces));
+    }
+    if (method == "GetSubTreePaths")
+    {
+        return toBatchValue(
+            tryGetSubTreePaths(interfaceMap, path, depth, interfaces));
+    }
+
+    std::string associationPath;
+    if (!batchArgument(arguments, "associationPath", associationPath))
+    {
+        return std::unexpected(QueryError::invalidArgument);
+    }
+    if (method == "GetAssociatedSubTree")
+    {
+        return toBatchValue(tryGetAssociatedSubTree(
+            interfaceMap, associationMaps,
+            sdbusplus::message::object_path(std::move(associationPath)),
+            sdbusplus::message::object_path(std::move(path)), depth,
+            interfaces));
+    }
+    if (method == "GetAssociatedSubTreePaths")
+    {
+        return toBatchValue(tryGetAssociatedSubTreePaths(
+            interfaceMap, associationMaps,
+            sdbusplus::message::object_path(std::move(associationPath)),
+            sdbusplus::message::object_path(std::move(path)), depth,
+            interfaces));
+    }
+    return std::unexpected(QueryError::invalidArgument);
+}
+
+std::vector<BatchResult> executeBatch(const InterfaceMapType& interfaceMap,
+                                      const AssociationMaps& associationMaps,
+                                      MissCache& missCache,
+                                      const std::vector<BatchQuery>& queries)
+{
+    std::vector<BatchResult> results;
+    results.reserve(queries.size());
+    for (const BatchQuery& query : queries)
+    {
+        auto result =
+            runBatchQuery(interfaceMap, associationMaps, missCache, query);
+        if (result)
+        {
+            results.emplace_back("", std::move(*result));
+        }
+        else
+        {
+            results.emplace_back(errorName(result.error()), BatchValue());
+        }
+    }
+    return results;
 }
@@ -1,30 +1,313 @@
 #pragma once
 
-#include "types.hpp"
+#include "interface_map.hpp"
+#include "miss_cache.hpp"
 
+#include <boost/container/flat_map.hpp>
+
+#include <cstdint>
 #include <string>
+#include <tuple>
+#include <utility>
+#include <variant>
 #include <vector>
 
+// The most paths a page of a subtree query returns
+constexpr uint32_t maxSubTreePageSize = 1000;
+
+/** @brief The D-Bus error name of a query error */
+const char* errorName(QueryError error);
+
+/** @brief The D-Bus error description of a query error */
+const char* errorDescription(QueryError error);
+
+/** @brief Throw the sdbusplus exception of a query error */
+[[noreturn]] void throwQueryError(QueryError error);
+
+/** @brief Get the value of a query result, or throw its error */
+template <typename T>
+T valueOrThrow(QueryResult<T>&& result)
+{
+    if (!result)
+    {
+        throwQueryError(result.error());
+    }
+    return std::move(*result);
+}
+
+/**
+ * @brief Add a connection and its interfaces on a path to a query result
+ *
+ * @param objectMap     The result so far
+ * @param objectPath    The object path
+ * @param interfaceMap  The connection name and its interfaces on the path
+ *
+ * All of the connections on a path have to be added one after another,
+ * which holds when walking the interface map in path order.
+ */
 void addObjectMapResult(std::vector<InterfaceMapType::value_type>& objectMap,
                         const std::string& objectPath,
-                        const ConnectionNames::value_type& interfaceMap);
+                        ConnectionNames::value_type interfaceMap);
+
+// The try functions return misses and other errors, and the functions
+// without the prefix throw them as sdbusplus exceptions.
+
+/**
+ * @brief Get the objects above a path
+ *
+ * @param interfaceMap  Mapper Structure storing all associations
+ * @param reqPath       The path to get the ancestors of
+ * @param interfaces    Interface filter
+ *
+ * A path that isn't in the interface map is a ResourceNotFound error.
+ *
+ * @return The ancestors that have any of the interfaces, in path order,
+ *         with their connections
+ */
+QueryResult<std::vector<InterfaceMapType::value_type>> tryGetAncestors(
+    const InterfaceMapType& interfaceMap, std::string reqPath,
+    std::vector<std::string>& interfaces);
 
 std::vector<InterfaceMapType::value_type> getAncestors(
     const InterfaceMapType& interfaceMap, std::string reqPath,
     std::vector<std::string>& interfaces);
 
+/**
+ * @brief Get the connections on a path
+ *
+ * @param interfaceMap  Mapper Structure storing all associations
+ * @param path          The object path
+ * @param interfaces    Interface filter
+ *
+ * A path that isn't in the interface map, or has none of the interfaces,
+ * is a ResourceNotFound error.
+ *
+ * @return The connections that have any of the interfaces, with their
+ *         interfaces
+ */
+QueryResult<ConnectionNames> tryGetObject(const InterfaceMapType& interfaceMap,
+                                          const std::string& path,
+                                          std::vector<std::string>& interfaces);
+
+/**
+ * @brief Get the connections on a path, remembering the paths that aren't
+ *        in the interface map
+ *
+ * @param interfaceMap  Mapper Structure storing all associations
+ * @param missCache     The paths earlier lookups didn't find
+ * @param path          The object path
+ * @param interfaces    Interface filter
+ *
+ * The same as tryGetObject() without the miss cache, except that a path
+ * in it is a ResourceNotFound error without a lookup, and a path that
+ * isn't in the interface map is added to it.  Only a missing path is
+ * cached, the interfaces don't matter for it.
+ *
+ * @return The connections that have any of the interfaces, with their
+ *         interfaces
+ */
+QueryResult<ConnectionNames> tryGetObject(const InterfaceMapType& interfaceMap,
+                                          MissCache& missCache,
+                                          const std::string& path,
+                                          std::vector<std::string>& interfaces);
+
 ConnectionNames getObject(const InterfaceMapType& interfaceMap,
                           const std::string& path,
                           std::vector<std::string>& interfaces);
 
+/**
+ * @brief Get the objects below a path
+ *
+ * @param interfaceMap  Mapper Structure storing all associations
+ * @param reqPath       Base path to search for the subtree
+ * @param depth         Level of depth to search into the base path, 0 or
+ *                      less for no limit
+ * @param interfaces    Interface filter
+ *
+ * A base path that isn't in the interface map is a ResourceNotFound
+ * error.
+ *
+ * @return The paths that have any of the interfaces, in path order, with
+ *         their connections
+ */
+QueryResult<std::vector<InterfaceMapType::value_type>> tryGetSubTree(
+    const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
+    std::vector<std::string>& interfaces);
+
 std::vector<InterfaceMapType::value_type> getSubTree(
     const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
     std::vector<std::string>& interfaces);
 
+/**
+ * @brief Get the paths of the objects below a path
+ *
+ * @param interfaceMap  Mapper Structure storing all associations
+ * @param reqPath       Base path to search for the subtree
+ * @param depth         Level of depth to search into the base path, 0 or
+ *                      less for no limit
+ * @param interfaces    Interface filter
+ *
+ * The same as tryGetSubTree(), but only with the paths.
+ *
+ * @return The paths that have any of the interfaces, in path order
+ */
+QueryResult<std::vector<std::string>> tryGetSubTreePaths(
+    const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
+    std::vector<std::string>& interfaces);
+
 std::vector<std::string> getSubTreePaths(const InterfaceMapType& interfaceMap,
                                          std::string reqPath, int32_t depth,
                                          std::vector<std::string>& interfaces);
 
+/** @brief The object paths of a service, with its interfaces on each */
+using ServiceObjects = std::vector<std::pair<std::string, InterfaceNames>>;
+
+/**
+ * @brief Get the objects of a service
+ *
+ * @param interfaceMap  Mapper Structure storing all associations
+ * @param service       The well-known name of the service
+ * @param interfaces    Interface filter
+ *
+ * Only the paths the service is on are visited.  An unknown service has
+ * no objects.
+ *
+ * @return The paths of the service that have any of the interfaces, in
+ *         path order, each with the interfaces the service has on it
+ */
+ServiceObjects getObjectsByService(const InterfaceMapType& interfaceMap,
+                                   const std::string& service,
+                                   std::vector<std::string>& interfaces);
+
+/**
+ * @brief Get the objects whose paths match a pattern
+ *
+ * @param interfaceMap  Mapper Structure storing all associations
+ * @param pattern       An object path with '*' and '?' globs in its
+ *                      segments, see PathPattern
+ * @param interfaces    Interface filter
+ *
+ * Only the parts of the path tree the pattern can match are walked.  The
+ * result has the same form and order as getSubTree(), and is empty if no
+ * path matches.  A pattern that isn't an absolute path is an
+ * InvalidArgument error.
+ *
+ * @return The matching paths and their connections
+ */
+QueryResult<std::vector<InterfaceMapType::value_type>> tryGetSubTreeByPattern(
+    const InterfaceMapType& interfaceMap, const std::string& pattern,
+    std::vector<std::string>& interfaces);
+
+std::vector<InterfaceMapType::value_type> getSubTreeByPattern(
+    const InterfaceMapType& interfaceMap, const std::string& pattern,
+    std::vector<std::string>& interfaces);
+
+/**
+ * @brief Get one page of a GetSubTree result
+ *
+ * @param interfaceMap  Mapper Structure storing all associations
+ * @param reqPath       Base path to search for the subtree
+ * @param depth         Level of depth to search into the base path
+ * @param interfaces    Interface filter
+ * @param pageSize      The most paths to return, 0 for the largest page
+ * @param token         The token returned with the previous page, or
+ *                      empty for the first page
+ *
+ * Pages are in object path order and the token marks where the previous
+ * page ended, so paths added or removed between pages don't make other
+ * paths be repeated or missed.  Paths are never returned twice.  A base
+ * path that isn't in the interface map is a ResourceNotFound error, and a
+ * token that doesn't belong to the query is an InvalidArgument error.
+ *
+ * @return The page, and the token for the next page or an empty string
+ *         if this was the last one
+ */
+QueryResult<std::tuple<std::vector<InterfaceMapType::value_type>, std::string>>
+    tryGetSubTreePage(const InterfaceMapType& interfaceMap, std::string reqPath,
+                      int32_t depth, std::vector<std::string>& interfaces,
+                      uint32_t pageSize, const std::string& token);
+
+std::tuple<std::vector<InterfaceMapType::value_type>, std::string>
+    getSubTreePage(const InterfaceMapType& interfaceMap, std::string reqPath,
+                   int32_t depth, std::vector<std::string>& interfaces,
+                   uint32_t pageSize, const std::string& token);
+
+/**
+ * @brief Get one page of a GetSubTreePaths result
+ *
+ * @param interfaceMap  Mapper Structure storing all associations
+ * @param reqPath       Base path to search for the subtree
+ * @param depth         Level of depth to search into the base path
+ * @param interfaces    Interface filter
+ * @param pageSize      The most paths to return, 0 for the largest page
+ * @param token         The token returned with the previous page, or
+ *                      empty for the first page
+ *
+ * The same as tryGetSubTreePage(), but only with the paths.
+ *
+ * @return The page, and the token for the next page or an empty string
+ *         if this was the last one
+ */
+QueryResult<std::tuple<std::vector<std::string>, std::string>>
+    tryGetSubTreePathsPage(const InterfaceMapType& interfaceMap,
+                           std::string reqPath, int32_t depth,
+                           std::vector<std::string>& interfaces,
+                           uint32_t pageSize, const std::string& token);
+
+std::tuple<std::vector<std::string>, std::string> getSubTreePathsPage(
+    const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
+    std::vector<std::string>& interfaces, uint32_t pageSize,
+    const std::string& token);
+
+/** @brief What getSubTreeCompact() returns for each object path */
+enum class SubTreeProjection : uint32_t
+{
+    // Only the object paths
+    paths = 0,
+    // The connections on each path, without interfaces
+    connections = 1,
+    // The connections and the interfaces of the filter they have
+    matchedInterfaces = 2,
+    // The connections and all of their interfaces, like getSubTree()
+    interfaces = 3,
+};
+
+/** @brief A connection and its interfaces, as indexes into the names */
+using CompactConnection = std::tuple<uint32_t, std::vector<uint32_t>>;
+
+/** @brief An object path and its connections in a compact subtree */
+using CompactObject = std::tuple<std::string, std::vector<CompactConnection>>;
+
+/** @brief The names a compact subtree refers to, and its object paths */
+using CompactSubTree =
+    std::tuple<std::vector<std::string>, std::vector<CompactObject>>;
+
+/**
+ * @brief Get a GetSubTree result in a smaller form
+ *
+ * @param interfaceMap  Mapper Structure storing all associations
+ * @param reqPath       Base path to search for the subtree
+ * @param depth         Level of depth to search into the base path
+ * @param interfaces    Interface filter
+ * @param projection    A SubTreeProjection value
+ *
+ * The same paths and connections as getSubTree() are returned, but each
+ * connection and interface name is only in the reply once.  Connections
+ * and interfaces refer to it by its index in the name list.  Parts the
+ * projection leaves out are empty.  An unknown projection is an
+ * InvalidArgument error.
+ *
+ * @return The name list and the object paths
+ */
+QueryResult<CompactSubTree> tryGetSubTreeCompact(
+    const InterfaceMapType& interfaceMap, std::string reqPath, int32_t depth,
+    std::vector<std::string>& interfaces, uint32_t projection);
+
+CompactSubTree getSubTreeCompact(const InterfaceMapType& interfaceMap,
+                                 std::string reqPath, int32_t depth,
+                                 std::vector<std::string>& interfaces,
+                                 uint32_t projection);
+
 /**
  * @brief Get the Associated Sub Tree object
  *
@@ -40,6 +323,14 @@ std::vector<std::string> getSubTreePaths(const InterfaceMapType& interfaceMap,
  *
  * @return std::vector<InterfaceMapType::value_type>
  */
+QueryResult<std::vector<InterfaceMapType::value_type>>
+    tryGetAssociatedSubTree(
+        const InterfaceMapType& interfaceMap,
+        const AssociationMaps& associationMaps,
+        const sdbusplus::message::object_path& associationPath,
+        const sdbusplus::message::object_path& reqPath, int32_t depth,
+        std::vector<std::string>& interfaces);
+
 std::vector<InterfaceMapType::value_type> getAssociatedSubTree(
     const InterfaceMapType& interfaceMap,
     const AssociationMaps& associationMaps,
@@ -62,6 +353,13 @@ std::vector<InterfaceMapType::value_type> getAssociatedSubTree(
  *
  * @return std::vector<std::string>
  */
+QueryResult<std::vector<std::string>> tryGetAssociatedSubTreePaths(
+    const InterfaceMapType& interfaceMap,
+    const AssociationMaps& associationMaps,
+    const sdbusplus::message::object_path& associationPath,
+    const sdbusplus::message::object_path& reqPath, int32_t depth,
+    std::vector<std::string>& interfaces);
+
 std::vector<std::string> getAssociatedSubTreePaths(
     const InterfaceMapType& interfaceMap,
     const AssociationMaps& associationMaps,
@@ -86,6 +384,15 @@ std::vector<std::string> getAssociatedSubTreePaths(
  *
  * @return std::vector<InterfaceMapType::value_type>
  */
+QueryResult<std::vector<InterfaceMapType::value_type>>
+    tryGetAssociatedSubTreeById(
+        const InterfaceMapType& interfaceMap,
+        const AssociationMaps& associationMaps, const std::string& id,
+        const std::string& objectPath,
+        std::vector<std::string>& subtreeInterfaces,
+        const std::string& association,
+        std::vector<std::string>& endpointInterfaces);
+
 std::vector<InterfaceMapType::value_type> getAssociatedSubTreeById(
     const InterfaceMapType& interfaceMap,
     const AssociationMaps& associationMaps, const std::string& id,
@@ -110,9 +417,65 @@ std::vector<InterfaceMapType::value_type> getAssociatedSubTreeById(
  *
  * @return std::vector<std::string>
  */
+QueryResult<std::vector<std::string>> tryGetAssociatedSubTreePathsById(
+    const InterfaceMapType& interfaceMap,
+    const AssociationMaps& associationMaps, const std::string& id,
+    const std::string& objectPath, std::vector<std::string>& subtreeInterfaces,
+    const std::string& association,
+    std::vector<std::string>& endpointInterfaces);
+
 std::vector<std::string> getAssociatedSubTreePathsById(
     const InterfaceMapType& interfaceMap,
     const AssociationMaps& associationMaps, const std::string& id,
     const std::string& objectPath, std::vector<std::string>& subtreeInterfaces,
     const std::string& association,
     std::vector<std::string>& endpointInterfaces);
+
+/** @brief An argument of a query in an ExecuteBatch call */
+using BatchArgument =
+    std::variant<std::string, int32_t, std::vector<std::string>>;
+
+/** @brief The arguments of a batched query, by name */
+using BatchArguments = boost::container::flat_map<std::string, BatchArgument>;
+
+/** @brief A batched query: a mapper method name and its arguments */
+using BatchQuery = std::tuple<std::string, BatchArguments>;
+
+/** @brief What a batched query returned */
+using BatchValue = std::variant<std::vector<std::string>, ConnectionNames,
+                                std::vector<InterfaceMapType::value_type>>;
+
+/** @brief The result of a batched query: the D-Bus error name, which is
+ *         empty if it succeeded, and what it returned
+ */
+using BatchResult = std::tuple<std::string, BatchValue>;
+
+/**
+ * @brief Run several queries in one call
+ *
+ * @param interfaceMap     Mapper Structure storing all associations
+ * @param associationMaps  Map of association between objects
+ * @param missCache        The paths earlier GetObject calls didn't find
+ * @param queries          The queries
+ *
+ * Each query names one of the GetObject, GetAncestors, GetSubTree,
+ * GetSubTreePaths, GetAssociatedSubTree, GetAssociatedSubTreePaths,
+ * GetAssociatedSubTreeById, GetAssociatedSubTreePathsById or
+ * GetSubTreeByPattern methods, and gives their arguments by the names of
+ * the parameters here: "path", "depth", "interfaces", "associationPath",
+ * "id", "association" and "endpointInterfaces".  The path of the ById
+ * methods and the pattern of GetSubTreeByPattern are "path" as well.
+ * A missing depth is 0 and missing interfaces are an empty filter, other
+ * arguments are required.  GetObject goes through the miss cache, the
+ * same as when it is called directly.
+ *
+ * A query that fails doesn't affect the others.  Its result has the
+ * error the method would have returned, and an empty value.  Unknown
+ * methods and missing or mistyped arguments are InvalidArgument errors.
+ *
+ * @return The result of each query, in the same order
+ */
+std::vector<BatchResult> executeBatch(const InterfaceMapType& interfaceMap,
+                                      const AssociationMaps& associationMaps,
+                                      MissCache& missCache,
+                                      const std::vector<BatchQuery>& queries);
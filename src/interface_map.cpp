@@ -0,0 +1,1166 @@
+#include "interface_map.hpp"
+
+#include <boost/container_hash/hash.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Object paths always start with '/', and everything after that is
+// a '/' separated list of segments.  The path "/" is a single empty
+// segment, and the empty path has no segments at all.
+static std::string_view stripRoot(std::string_view path)
+{
+    if (path.starts_with('/'))
+    {
+        path.remove_prefix(1);
+    }
+    return path;
+}
+
+NameId NameTable::intern(std::string_view name)
+{
+    auto it = ids.find(name);
+    if (it != ids.end())
+    {
+        return it->second;
+    }
+    auto id = static_cast<NameId>(names.size());
+    const std::string& stored = names.emplace_back(name);
+    ids.emplace(stored, id);
+    return id;
+}
+
+std::optional<NameId> NameTable::find(std::string_view name) const
+{
+    auto it = ids.find(name);
+    if (it == ids.end())
+    {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+static NameTable makeNameTable()
+{
+    NameTable table;
+    for (std::string_view interface : standardInterfaces)
+    {
+        table.intern(interface);
+    }
+    return table;
+}
+
+NameTable& nameTable()
+{
+    static NameTable table = makeNameTable();
+    return table;
+}
+
+// All of the distinct interface sets, keyed by their contents
+class InterfaceSetPool
+{
+  public:
+    using Shared = InterfaceIds::Shared;
+
+    static size_t hash(uint8_t standard, std::span<const NameId> ids)
+    {
+        size_t seed = standard;
+        boost::hash_range(seed, ids.begin(), ids.end());
+        return seed;
+    }
+
+    Shared* find(uint8_t standard, std::span<const NameId> ids,
+                 size_t hash) const
+    {
+        auto it = sets.find(Key{standard, ids, hash});
+        return it == sets.end() ? nullptr : *it;
+    }
+
+    void insert(Shared* shared)
+    {
+        sets.emplace(shared);
+    }
+
+    void erase(Shared* shared)
+    {
+        sets.erase(shared);
+    }
+
+    InterfaceSetStats stats() const
+    {
+        InterfaceSetStats result;
+        result.sets = sets.size();
+        for (const Shared* shared : sets)
+        {
+            result.references += shared->refs;
+            result.storedIds += shared->ids.size();
+            result.referencedIds += shared->refs * shared->ids.size();
+        }
+        return result;
+    }
+
+  private:
+    struct Key
+    {
+        uint8_t standard;
+        std::span<const NameId> ids;
+        size_t hash;
+    };
+
+    struct Hash
+    {
+        using is_transparent = void;
+
+        size_t operator()(const Shared* shared) const
+        {
+            return shared->hash;
+        }
+
+        size_t operator()(const Key& key) const
+        {
+            return key.hash;
+        }
+    };
+
+    struct Equal
+    {
+        using is_transparent = void;
+
+        static bool equal(const Key& lhs, const Shared* rhs)
+        {
+            return lhs.standard == rhs->standard &&
+                   std::ranges::equal(lhs.ids, rhs->ids);
+        }
+
+        bool operator()(const Shared* lhs, const Shared* rhs) const
+        {
+            return lhs == rhs;
+        }
+
+        bool operator()(const Key& lhs, const Shared* rhs) const
+        {
+            return equal(lhs, rhs);
+        }
+
+        bool operator()(const Shared* lhs, const Key& rhs) const
+        {
+            return equal(rhs, lhs);
+        }
+    };
+
+    std::unordered_set<Shared*, Hash, Equal> sets;
+};
+
+// Never destroyed, so interface sets can still be released by statics
+// that are destroyed after it would be
+static InterfaceSetPool& interfaceSetPool()
+{
+    static auto* pool = new InterfaceSetPool;
+    return *pool;
+}
+
+InterfaceSetStats interfaceSetStats()
+{
+    return interfaceSetPool().stats();
+}
+
+static uint8_t standardBit(NameId id)
+{
+    return static_cast<uint8_t>(1U << id);
+}
+
+bool InterfaceIds::contains(NameId id) const
+{
+    if (isStandardInterface(id))
+    {
+        return (standard() & standardBit(id)) != 0;
+    }
+    return std::ranges::binary_search(named(), id);
+}
+
+InterfaceIds InterfaceIds::insert(NameId id) const
+{
+    if (isStandardInterface(id))
+    {
+        if ((standard() & standardBit(id)) != 0)
+        {
+            return *this;
+        }
+        std::span<const NameId> stored = named();
+        return intern(standard() | standardBit(id),
+                      std::vector<NameId>(stored.begin(), stored.end()));
+    }
+
+    std::span<const NameId> stored = named();
+    auto pos = std::ranges::lower_bound(stored, id);
+    if (pos != stored.end() && *pos == id)
+    {
+        return *this;
+    }
+    std::vector<NameId> ids;
+    ids.reserve(stored.size() + 1);
+    ids.insert(ids.end(), stored.begin(), pos);
+    ids.emplace_back(id);
+    ids.insert(ids.end(), pos, stored.end());
+    return intern(standard(), std::move(ids));
+}
+
+InterfaceIds InterfaceIds::insert(std::span<const NameId> ids) const
+{
+    // The standard interfaces have the lowest IDs, so they come first
+    uint8_t bits = standard();
+    auto rest = ids.begin();
+    for (; rest != ids.end() && isStandardInterface(*rest); ++rest)
+    {
+        bits |= standardBit(*rest);
+    }
+    std::span<const NameId> added(rest, ids.end());
+
+    std::span<const NameId> stored = named();
+    if (bits == standard() && std::ranges::includes(stored, added))
+    {
+        return *this;
+    }
+    std::vector<NameId> merged;
+    merged.reserve(stored.size() + added.size());
+    std::ranges::set_union(stored, added, std::back_inserter(merged));
+    return intern(bits, std::move(merged));
+}
+
+InterfaceIds InterfaceIds::erase(NameId id) const
+{
+    std::span<const NameId> stored = named();
+    if (isStandardInterface(id))
+    {
+        if ((standard() & standardBit(id)) == 0)
+        {
+            return *this;
+        }
+        return intern(standard() & ~standardBit(id),
+                      std::vector<NameId>(stored.begin(), stored.end()));
+    }
+
+    auto pos = std::ranges::lower_bound(stored, id);
+    if (pos == stored.end() || *pos != id)
+    {
+        return *this;
+    }
+    std::vector<NameId> ids;
+    ids.reserve(stored.size() - 1);
+    ids.insert(ids.end(), stored.begin(), pos);
+    ids.insert(ids.end(), pos + 1, stored.end());
+    return intern(standard(), std::move(ids));
+}
+
+InterfaceIds InterfaceIds::intern(uint8_t standard, std::vector<NameId>&& ids)
+{
+    InterfaceIds result;
+    if (standard == 0 && ids.empty())
+    {
+        return result;
+    }
+
+    InterfaceSetPool& pool = interfaceSetPool();
+    size_t hash = InterfaceSetPool::hash(standard, ids);
+    result.shared = pool.find(standard, ids, hash);
+    if (result.shared != nullptr)
+    {
+        result.shared->refs++;
+        return result;
+    }
+
+    ids.shrink_to_fit();
+    result.shared = new Shared{1, hash, standard, std::move(ids)};
+    pool.insert(result.shared);
+    return result;
+}
+
+void InterfaceIds::release()
+{
+    if (shared != nullptr && --shared->refs == 0)
+    {
+        interfaceSetPool().erase(shared);
+        delete shared;
+    }
+    shared = nullptr;
+}
+
+const InterfaceIds* findInterfaces(const ConnectionIds& connections,
+                                   std::string_view connection)
+{
+    auto id = nameTable().find(connection);
+    if (!id)
+    {
+        return nullptr;
+    }
+    auto it = connections.find(*id);
+    if (it == connections.end())
+    {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+bool containsInterface(const InterfaceIds& interfaces,
+                       std::string_view interface)
+{
+    auto id = nameTable().find(interface);
+    return id && interfaces.contains(*id);
+}
+
+InterfaceNames toInterfaceNames(const InterfaceIds& interfaces)
+{
+    const NameTable& names = nameTable();
+    InterfaceNames result;
+    result.reserve(interfaces.size());
+    for (NameId interface : interfaces)
+    {
+        result.emplace(names[interface]);
+    }
+    return result;
+}
+
+ConnectionNames toConnectionNames(const ConnectionIds& connections)
+{
+    const NameTable& names = nameTable();
+    ConnectionNames result;
+    result.reserve(connections.size());
+    for (const auto& [connection, interfaces] : connections)
+    {
+        result.emplace(names[connection], toInterfaceNames(interfaces));
+    }
+    return result;
+}
+
+InterfaceFilter::InterfaceFilter(const std::vector<std::string>& interfaces) :
+    filtered(!interfaces.empty())
+{
+    const NameTable& names = nameTable();
+    for (const auto& interface : interfaces)
+    {
+        auto id = names.find(interface);
+        if (id)
+        {
+            interfaceIds.emplace_back(*id);
+        }
+    }
+    std::sort(interfaceIds.begin(), interfaceIds.end());
+    interfaceIds.erase(std::unique(interfaceIds.begin(), interfaceIds.end()),
+                       interfaceIds.end());
+    for (NameId id : interfaceIds)
+    {
+        if (isStandardInterface(id))
+        {
+            standardIds |= standardBit(id);
+        }
+    }
+}
+
+bool InterfaceFilter::intersects(const InterfaceIds& interfaces) const
+{
+    if ((standardIds & interfaces.standard()) != 0)
+    {
+        return true;
+    }
+
+    // Both are sorted, so walk them together
+    std::span<const NameId> named = interfaces.named();
+    auto lhs = interfaceIds.begin();
+    auto rhs = named.begin();
+    while (lhs != interfaceIds.end() && rhs != named.end())
+    {
+        if (*lhs < *rhs)
+        {
+            ++lhs;
+        }
+        else if (*rhs < *lhs)
+        {
+            ++rhs;
+        }
+        else
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The first position in the array whose path isn't less, as a binary
+// search that steps over holes.  Each run of holes is stepped over at most
+// once, since the search then moves past it either way.
+template <typename Less>
+size_t InterfaceMapType::PathSet::frozenBound(Less less) const
+{
+    size_t low = 0;
+    size_t high = frozen.size();
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        size_t live = mid;
+        while (live < high && frozen[live] == nullptr)
+        {
+            live++;
+        }
+        if (live < high && less(frozen[live]))
+        {
+            low = live + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+size_t InterfaceMapType::PathSet::findFrozen(const PathNode* node) const
+{
+    const std::string& path = node->entry->first;
+    size_t pos = frozenBound(
+        [&path](const PathNode* other) { return other->entry->first < path; });
+    while (pos < frozen.size() && frozen[pos] == nullptr)
+    {
+        pos++;
+    }
+    if (pos < frozen.size() && frozen[pos] == node)
+    {
+        return pos;
+    }
+    return frozen.size();
+}
+
+InterfaceMapType::PathSet::const_iterator
+    InterfaceMapType::PathSet::lower_bound(std::string_view path) const
+{
+    return iteratorAt(frozenBound([path](const PathNode* node) {
+                          return node->entry->first < path;
+                      }),
+                      added.lower_bound(path));
+}
+
+InterfaceMapType::PathSet::const_iterator
+    InterfaceMapType::PathSet::upper_bound(std::string_view path) const
+{
+    return iteratorAt(frozenBound([path](const PathNode* node) {
+                          return node->entry->first <= path;
+                      }),
+                      added.upper_bound(path));
+}
+
+bool InterfaceMapType::PathSet::insert(const PathNode* node)
+{
+    if (findFrozen(node) != frozen.size() || !added.insert(node).second)
+    {
+        return false;
+    }
+    mergeIfNeeded();
+    return true;
+}
+
+bool InterfaceMapType::PathSet::erase(const PathNode* node)
+{
+    size_t pos = findFrozen(node);
+    if (pos != frozen.size())
+    {
+        frozen[pos] = nullptr;
+        holes++;
+    }
+    else if (added.erase(node) == 0)
+    {
+        return false;
+    }
+    mergeIfNeeded();
+    return true;
+}
+
+void InterfaceMapType::PathSet::mergeIfNeeded()
+{
+    if (added.size() + holes < std::max(minMerge, frozen.size() / 8))
+    {
+        return;
+    }
+    std::pmr::vector<const PathNode*> merged(frozen.get_allocator());
+    merged.reserve(size());
+    std::copy(begin(), end(), std::back_inserter(merged));
+    frozen = std::move(merged);
+    holes = 0;
+    added.clear();
+}
+
+InterfaceMapType::InterfaceMapType() : tree(std::make_unique<PathNode>()) {}
+
+InterfaceMapType::InterfaceMapType(std::initializer_list<value_type> init) :
+    InterfaceMapType()
+{
+    for (const auto& [path, connections] : init)
+    {
+        auto pathIt = emplace(path).first;
+        for (const auto& [connection, interfaces] : connections)
+        {
+            addConnection(pathIt, connection);
+            for (const auto& interface : interfaces)
+            {
+                addInterface(pathIt, connection, interface);
+            }
+        }
+    }
+}
+
+std::pair<InterfaceMapType::const_iterator, bool> InterfaceMapType::emplace(
+    const std::string& path)
+{
+    return emplace(paths.end(), path);
+}
+
+std::pair<InterfaceMapType::const_iterator, bool>
+    InterfaceMapType::emplace(const_iterator hint, std::string_view path)
+{
+    size_t before = paths.size();
+    auto pathIt = paths.try_emplace(hint, path);
+    bool inserted = paths.size() != before;
+    if (inserted)
+    {
+        PathNode& node = insertNode(path);
+        node.entry = &*pathIt;
+        uint64_t generation = ++lastGeneration;
+        for (PathNode* n = &node; n != nullptr; n = n->parent)
+        {
+            n->count++;
+            n->generation = generation;
+        }
+        leafPaths.emplace(&node);
+    }
+    return {pathIt, inserted};
+}
+
+bool InterfaceMapType::addConnection(const_iterator path,
+                                     std::string_view connection)
+{
+    auto& connections = mutableIterator(path)->second;
+    NameId connectionId = nameTable().intern(connection);
+    if (!connections.emplace(connectionId, InterfaceIds{}).second)
+    {
+        return false;
+    }
+    indexConnection(insertNode(path->first.str()), connectionId);
+    touch(path);
+    return true;
+}
+
+void InterfaceMapType::addInterface(const_iterator path,
+                                    std::string_view connection,
+                                    std::string_view interface)
+{
+    NameTable& names = nameTable();
+    NameId interfaceId = names.intern(interface);
+    NameId connectionId = names.intern(connection);
+    auto& connections = mutableIterator(path)->second;
+    auto [found, added] = connections.try_emplace(connectionId);
+    if (added)
+    {
+        indexConnection(insertNode(path->first.str()), connectionId);
+    }
+    InterfaceIds& interfaces = found->second;
+    if (!interfaces.contains(interfaceId))
+    {
+        interfaces = interfaces.insert(interfaceId);
+        indexInterface(path, interfaceId);
+        touch(path);
+    }
+}
+
+void InterfaceMapType::addInterfaces(const_iterator path,
+                                     std::string_view connection,
+                                     std::span<const NameId> interfaces)
+{
+    if (interfaces.empty())
+    {
+        return;
+    }
+    NameId connectionId = nameTable().intern(connection);
+    auto& connections = mutableIterator(path)->second;
+    auto [found, added] = connections.try_emplace(connectionId);
+    if (added)
+    {
+        indexConnection(insertNode(path->first.str()), connectionId);
+    }
+    InterfaceIds& current = found->second;
+    InterfaceIds merged = current.insert(interfaces);
+    if (merged == current)
+    {
+        return;
+    }
+    for (NameId interfaceId : interfaces)
+    {
+        if (!current.contains(interfaceId))
+        {
+            indexInterface(path, interfaceId);
+        }
+    }
+    current = std::move(merged);
+    touch(path);
+}
+
+bool InterfaceMapType::removeInterface(const_iterator path,
+                                       std::string_view connection,
+                                       std::string_view interface)
+{
+    const NameTable& names = nameTable();
+    auto connectionId = names.find(connection);
+    if (!connectionId)
+    {
+        return false;
+    }
+    auto& connections = mutableIterator(path)->second;
+    auto interfaces = connections.find(*connectionId);
+    if (interfaces == connections.end())
+    {
+        return false;
+    }
+
+    auto interfaceId = names.find(interface);
+    if (interfaceId && interfaces->second.contains(*interfaceId))
+    {
+        interfaces->second = interfaces->second.erase(*interfaceId);
+        unindexInterface(path, *interfaceId);
+        touch(path);
+    }
+
+    if (!interfaces->second.empty())
+    {
+        return false;
+    }
+    connections.erase(interfaces);
+    unindexConnection(insertNode(path->first.str()), *connectionId);
+    touch(path);
+    return true;
+}
+
+bool InterfaceMapType::removeConnection(const_iterator path,
+                                        std::string_view connection)
+{
+    auto connectionId = nameTable().find(connection);
+    if (!connectionId)
+    {
+        return false;
+    }
+    auto& connections = mutableIterator(path)->second;
+    auto interfaces = connections.find(*connectionId);
+    if (interfaces == connections.end())
+    {
+        return false;
+    }
+    InterfaceIds removed = std::move(interfaces->second);
+    connections.erase(interfaces);
+    unindexConnection(insertNode(path->first.str()), *connectionId);
+
+    for (NameId interface : removed)
+    {
+        unindexInterface(path, interface);
+    }
+    touch(path);
+    return true;
+}
+
+void InterfaceMapType::removeConnection(std::string_view connection)
+{
+    auto connectionId = nameTable().find(connection);
+    if (!connectionId)
+    {
+        return;
+    }
+    auto index = connectionPaths.find(*connectionId);
+    if (index == connectionPaths.end())
+    {
+        return;
+    }
+    std::unique_ptr<ConnectionPaths> owned = std::move(index->second);
+    connectionPaths.erase(index);
+
+    // Erasing paths can free the tree nodes the index compares, so the
+    // paths are found before any of them changes
+    std::vector<const_iterator> ownedPaths;
+    ownedPaths.reserve(owned->paths.size());
+    for (const PathNode* node : owned->paths)
+    {
+        ownedPaths.emplace_back(paths.find(node->entry->first.str()));
+    }
+    for (const_iterator path : ownedPaths)
+    {
+        removeConnection(path, connection);
+        if (path->second.empty())
+        {
+            erase(path);
+        }
+    }
+}
+
+InterfaceMapType::const_iterator InterfaceMapType::erase(const_iterator path)
+{
+    PathNode* node = &insertNode(path->first.str());
+    for (const auto& [connection, interfaces] : path->second)
+    {
+        unindexConnection(*node, connection);
+        for (NameId interface : interfaces.named())
+        {
+            auto index = interfacePaths.find(interface);
+            if (index == interfacePaths.end())
+            {
+                continue;
+            }
+            index->second.erase(node);
+            if (index->second.empty())
+            {
+                interfacePaths.erase(index);
+            }
+        }
+    }
+
+    leafPaths.erase(node);
+    touch(path);
+    releaseNode(path->first.str());
+    return paths.erase(path);
+}
+
+const InterfaceMapType::PathSet* InterfaceMapType::findInterface(
+    std::string_view interface) const
+{
+    auto id = nameTable().find(interface);
+    if (!id)
+    {
+        return nullptr;
+    }
+    return findInterface(*id);
+}
+
+const InterfaceMapType::PathSet* InterfaceMapType::findInterface(
+    NameId interface) const
+{
+    auto index = interfacePaths.find(interface);
+    if (index == interfacePaths.end())
+    {
+        return nullptr;
+    }
+    return &index->second;
+}
+
+const InterfaceMapType::PathSet* InterfaceMapType::findConnection(
+    std::string_view connection) const
+{
+    auto id = nameTable().find(connection);
+    if (!id)
+    {
+        return nullptr;
+    }
+    auto index = connectionPaths.find(*id);
+    if (index == connectionPaths.end())
+    {
+        return nullptr;
+    }
+    return &index->second->paths;
+}
+
+bool InterfaceMapType::hasConnectionBelow(const_iterator path,
+                                          std::string_view connection) const
+{
+    auto id = nameTable().find(connection);
+    if (!id)
+    {
+        return false;
+    }
+    const PathNode* node = findNode(path->first.str());
+    return node->connectionsBelow.contains(*id);
+}
+
+void InterfaceMapType::indexConnection(PathNode& node, NameId connection)
+{
+    auto& index = connectionPaths[connection];
+    if (index == nullptr)
+    {
+        index = std::make_unique<ConnectionPaths>();
+    }
+    index->paths.insert(&node);
+    for (PathNode* n = node.parent; n != nullptr; n = n->parent)
+    {
+        n->connectionsBelow[connection]++;
+    }
+}
+
+void InterfaceMapType::unindexConnection(PathNode& node, NameId connection)
+{
+    // removeConnection() takes the index out before it visits the paths
+    auto index = connectionPaths.find(connection);
+    if (index != connectionPaths.end())
+    {
+        index->second->paths.erase(&node);
+        if (index->second->paths.empty())
+        {
+            connectionPaths.erase(index);
+        }
+    }
+
+    // Counts are only kept while they aren't 0
+    for (PathNode* n = node.parent; n != nullptr; n = n->parent)
+    {
+        auto below = n->connectionsBelow.find(connection);
+        if (--below->second == 0)
+        {
+            n->connectionsBelow.erase(below);
+        }
+    }
+}
+
+void InterfaceMapType::indexInterface(const_iterator path, NameId interface)
+{
+    if (isStandardInterface(interface))
+    {
+        return;
+    }
+    interfacePaths[interface].insert(findNode(path->first.str()));
+}
+
+void InterfaceMapType::unindexInterface(const_iterator path, NameId interface)
+{
+    if (isStandardInterface(interface))
+    {
+        return;
+    }
+
+    // The path stays in the index while any connection still has it
+    for (const auto& [_, interfaces] : path->second)
+    {
+        if (interfaces.contains(interface))
+        {
+            return;
+        }
+    }
+
+    auto index = interfacePaths.find(interface);
+    if (index == interfacePaths.end())
+    {
+        return;
+    }
+    index->second.erase(findNode(path->first.str()));
+    if (index->second.empty())
+    {
+        interfacePaths.erase(index);
+    }
+}
+
+size_t InterfaceMapType::findIndexes(const InterfaceFilter& interfaces,
+                                     std::vector<const PathSet*>& indexes) const
+{
+    // Nearly every path has a standard interface, so walking the tree is
+    // about as cheap as any index of them would be
+    if (interfaces.standard() != 0)
+    {
+        return std::numeric_limits<size_t>::max();
+    }
+
+    size_t indexed = 0;
+    for (NameId interface : interfaces.ids())
+    {
+        const PathSet* index = findInterface(interface);
+        if (index != nullptr)
+        {
+            indexes.emplace_back(index);
+            indexed += index->size();
+        }
+    }
+    return indexed;
+}
+
+// Add the entries below node that come after the rest of a path, relative
+// to node, to found.  Without a path, all of the entries below node come
+// after it.  Returns false once found is full.
+template <typename Keep>
+static bool findDescendantsAfter(const PathNode& node, int32_t depth,
+                                 std::optional<std::string_view> after,
+                                 Keep& keep, size_t limit,
+                                 std::vector<const PathNode*>& found)
+{
+    auto child = node.children.begin();
+    if (after)
+    {
+        size_t end = after->find('/');
+        std::string_view segment = after->substr(0, end);
+        child = node.children.lower_bound(segment);
+        if (child != node.children.end() && child->first == segment)
+        {
+            // The child is the path itself or above it, so only some of
+            // the entries below the child come after it
+            std::optional<std::string_view> rest;
+            if (end != std::string_view::npos)
+            {
+                rest = after->substr(end + 1);
+            }
+            if (depth > 1 && !findDescendantsAfter(*child->second, depth - 1,
+                                                   rest, keep, limit, found))
+            {
+                return false;
+            }
+            ++child;
+        }
+    }
+
+    for (; child != node.children.end(); ++child)
+    {
+        const PathNode& childNode = *child->second;
+        if (childNode.entry != nullptr && keep(childNode))
+        {
+            found.emplace_back(&childNode);
+            if (found.size() >= limit)
+            {
+                return false;
+            }
+        }
+        if (depth > 1 && !findDescendantsAfter(childNode, depth - 1,
+                                               std::nullopt, keep, limit,
+                                               found))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<const PathNode*> InterfaceMapType::findDescendants(
+    const PathNode& node, std::string_view path, int32_t depth,
+    const InterfaceFilter& interfaces, std::string_view after,
+    size_t limit) const
+{
+    std::vector<const PathNode*> found;
+    if (limit == 0)
+    {
+        return found;
+    }
+
+    std::vector<const PathSet*> indexes;
+    if (interfaces.empty() || findIndexes(interfaces, indexes) >= node.count)
+    {
+        auto keep = [&interfaces](const PathNode& child) {
+            return interfaces.empty() ||
+                   std::any_of(child.entry->second.begin(),
+                               child.entry->second.end(),
+                               [&interfaces](const auto& connection) {
+                                   return interfaces.intersects(
+                                       connection.second);
+                               });
+        };
+
+        std::optional<std::string_view> below;
+        if (!after.empty())
+        {
+            below = stripRoot(after.substr(path.size()));
+        }
+        findDescendantsAfter(node, depth, below, keep, limit, found);
+        return found;
+    }
+
+    // Take up to a page from each interface, then keep the first page of
+    // all of them
+    std::string prefix(path);
+    prefix += '/';
+    for (const PathSet* index : indexes)
+    {
+        auto it = after.empty() ? index->lower_bound(prefix)
+                                : index->upper_bound(after);
+        size_t taken = 0;
+        for (; it != index->end() && taken < limit; ++it)
+        {
+            const std::string& thisPath = (*it)->entry->first;
+            if (!thisPath.starts_with(prefix))
+            {
+                break;
+            }
+            std::string_view below =
+                std::string_view(thisPath).substr(path.size());
+            if (std::count(below.begin(), below.end(), '/') <= depth)
+            {
+                found.emplace_back(*it);
+                taken++;
+            }
+        }
+    }
+
+    std::sort(found.begin(), found.end(), PathOrder());
+    found.erase(std::unique(found.begin(), found.end()), found.end());
+    if (found.size() > limit)
+    {
+        found.resize(limit);
+    }
+    return found;
+}
+
+bool InterfaceMapType::findCandidates(
+    const PathNode& node, std::string_view path, int32_t depth,
+    const InterfaceFilter& interfaces, std::vector<const PathNode*>& candidates)
+    const
+{
+    if (interfaces.empty())
+    {
+        return false;
+    }
+
+    std::vector<const PathSet*> indexes;
+
+    // Walking the tree is cheaper if most of the subtree matches anyway
+    if (findIndexes(interfaces, indexes) >= node.count)
+    {
+        return false;
+    }
+
+    std::string prefix(path);
+    prefix += '/';
+    for (const PathSet* index : indexes)
+    {
+        for (auto it = index->lower_bound(prefix); it != index->end(); ++it)
+        {
+            const std::string& thisPath = (*it)->entry->first;
+            if (!thisPath.starts_with(prefix))
+            {
+                break;
+            }
+            std::string_view below =
+                std::string_view(thisPath).substr(path.size());
+            auto thisDepth = std::count(below.begin(), below.end(), '/');
+            if (thisDepth <= depth)
+            {
+                candidates.emplace_back(*it);
+            }
+        }
+    }
+
+    // An object with more than one of the interfaces is only visited once
+    std::sort(candidates.begin(), candidates.end(), PathOrder());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                     candidates.end());
+    return true;
+}
+
+const PathNode* InterfaceMapType::findNode(std::string_view path) const
+{
+    const PathNode* node = tree.get();
+    if (path.empty())
+    {
+        return node;
+    }
+
+    path = stripRoot(path);
+    for (size_t pos = 0, end = 0; end != std::string_view::npos; pos = end + 1)
+    {
+        end = path.find('/', pos);
+        auto child = node->children.find(path.substr(pos, end - pos));
+        if (child == node->children.end())
+        {
+            return nullptr;
+        }
+        node = child->second.get();
+    }
+    return node;
+}
+
+std::vector<const PathNode*> InterfaceMapType::findAncestors(
+    std::string_view path) const
+{
+    std::vector<const PathNode*> ancestors;
+    if (path.empty())
+    {
+        return ancestors;
+    }
+
+    const PathNode* node = tree.get();
+    if (node->entry != nullptr)
+    {
+        ancestors.emplace_back(node);
+    }
+    if (path == "/")
+    {
+        return ancestors;
+    }
+    auto slash = node->children.find(std::string_view());
+    if (slash != node->children.end() && slash->second->entry != nullptr)
+    {
+        ancestors.emplace_back(slash->second.get());
+    }
+
+    // Every segment but the last one leads to an ancestor
+    path = stripRoot(path);
+    for (size_t pos = 0, end = path.find('/'); end != std::string_view::npos;
+         pos = end + 1, end = path.find('/', pos))
+    {
+        auto child = node->children.find(path.substr(pos, end - pos));
+        if (child == node->children.end())
+        {
+            break;
+        }
+        node = child->second.get();
+        if (node->entry != nullptr)
+        {
+            ancestors.emplace_back(node);
+        }
+    }
+    return ancestors;
+}
+
+PathNode& InterfaceMapType::insertNode(std::string_view path)
+{
+    PathNode* node = tree.get();
+    if (path.empty())
+    {
+        return *node;
+    }
+
+    path = stripRoot(path);
+    for (size_t pos = 0, end = 0; end != std::string_view::npos; pos = end + 1)
+    {
+        end = path.find('/', pos);
+        std::string_view segment = path.substr(pos, end - pos);
+        auto child = node->children.find(segment);
+        if (child == node->children.end())
+        {
+            auto newNode = std::make_unique<PathNode>(node, segment);
+            std::string_view key = newNode->segment;
+            child = node->children.emplace(key, std::move(newNode)).first;
+        }
+        node = child->second.get();
+    }
+    return *node;
+}
+
+void InterfaceMapType::touch(const_iterator path)
+{
+    uint64_t generation = ++lastGeneration;
+    for (PathNode* node = &insertNode(path->first.str()); node != nullptr;
+         node = node->parent)
+    {
+        node->generation = generation;
+    }
+}
+
+void InterfaceMapType::releaseNode(std::string_view path)
+{
+    PathNode* node = &insertNode(path);
+    node->entry = nullptr;
+    for (PathNode* n = node; n != nullptr; n = n->parent)
+    {
+        n->count--;
+    }
+
+    // Prune the branch back up to the closest node that is still needed
+    while (node->parent != nullptr && node->count == 0)
+    {
+        PathNode* parent = node->parent;
+        parent->children.erase(parent->children.find(node->segment));
+        node = parent;
+    }
+}
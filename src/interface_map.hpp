@@ -0,0 +1,987 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <boost/container/flat_map.hpp>
+#include <boost/container/small_vector.hpp>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <ranges>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** @brief The ID of an interned connection or interface name */
+using NameId = uint32_t;
+
+/** @brief A table of interned connection and interface names.
+ *
+ * The same few hundred names show up on almost every object path, so the
+ * interface map stores a small ID for each of them instead of a copy of
+ * the string.  IDs are never reused, which is fine since the set of names
+ * on a system is small and doesn't grow without bound.
+ */
+class NameTable
+{
+  public:
+    /** @brief Get the ID of a name, adding the name if it is new */
+    NameId intern(std::string_view name);
+
+    /** @brief Get the ID of a name, if it was ever added */
+    std::optional<NameId> find(std::string_view name) const;
+
+    /** @brief Get the name of an ID */
+    const std::string& operator[](NameId id) const
+    {
+        return names[id];
+    }
+
+    size_t size() const
+    {
+        return names.size();
+    }
+
+  private:
+    // A deque so the keys of ids stay valid as names are added
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, NameId> ids;
+};
+
+/** @brief The standard freedesktop interfaces, which nearly every object
+ *         path has.
+ *
+ * nameTable() gives them the first IDs, in this order, so an interface set
+ * can keep them as bits rather than storing their IDs, and the interface
+ * map doesn't index the paths that have them.
+ */
+inline constexpr std::array<std::string_view, 3> standardInterfaces = {
+    "org.freedesktop.DBus.Introspectable", "org.freedesktop.DBus.Peer",
+    "org.freedesktop.DBus.Properties"};
+
+/** @brief The bits of all of the standard interfaces */
+inline constexpr uint8_t allStandardInterfaces =
+    (1U << standardInterfaces.size()) - 1;
+
+/** @brief Check if an interface ID is one of standardInterfaces */
+inline bool isStandardInterface(NameId id)
+{
+    return id < standardInterfaces.size();
+}
+
+/** @brief The name table shared by every interface map, which starts with
+ *         standardInterfaces
+ */
+NameTable& nameTable();
+
+/** @brief The interfaces of a connection on a path, sorted by ID.
+ *
+ * Objects from the same service nearly always have exactly the same
+ * interfaces, so equal sets are stored once and shared by every path that
+ * has them.  A set is never changed in place.  insert() and erase() return
+ * the set with the change made, which is shared with other paths in turn.
+ *
+ * The standard interfaces are kept as bits, and only the other interfaces
+ * are stored as IDs.  Iterating the set still visits both.
+ */
+class InterfaceIds
+{
+  public:
+    /** @brief Visits the standard interfaces, then the stored ones */
+    class const_iterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = NameId;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const NameId*;
+        using reference = NameId;
+
+        const_iterator() = default;
+
+        NameId operator*() const
+        {
+            if (standardLeft != 0)
+            {
+                return static_cast<NameId>(std::countr_zero(standardLeft));
+            }
+            return *stored;
+        }
+
+        const_iterator& operator++()
+        {
+            if (standardLeft != 0)
+            {
+                standardLeft &= standardLeft - 1;
+            }
+            else
+            {
+                ++stored;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const const_iterator& lhs,
+                               const const_iterator& rhs)
+        {
+            return lhs.standardLeft == rhs.standardLeft &&
+                   lhs.stored == rhs.stored;
+        }
+
+      private:
+        friend class InterfaceIds;
+
+        const_iterator(unsigned standard, const NameId* pos) :
+            standardLeft(standard), stored(pos)
+        {}
+
+        unsigned standardLeft = 0;
+        const NameId* stored = nullptr;
+    };
+
+    InterfaceIds() = default;
+
+    InterfaceIds(const InterfaceIds& other) : shared(other.shared)
+    {
+        if (shared != nullptr)
+        {
+            shared->refs++;
+        }
+    }
+
+    InterfaceIds(InterfaceIds&& other) noexcept :
+        shared(std::exchange(other.shared, nullptr))
+    {}
+
+    InterfaceIds& operator=(const InterfaceIds& other)
+    {
+        InterfaceIds(other).swap(*this);
+        return *this;
+    }
+
+    InterfaceIds& operator=(InterfaceIds&& other) noexcept
+    {
+        InterfaceIds(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~InterfaceIds()
+    {
+        release();
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(standard(), named().data());
+    }
+
+    const_iterator end() const
+    {
+        std::span<const NameId> ids = named();
+        return const_iterator(0, ids.data() + ids.size());
+    }
+
+    size_t size() const
+    {
+        return static_cast<size_t>(std::popcount(standard())) +
+               named().size();
+    }
+
+    bool empty() const
+    {
+        return shared == nullptr;
+    }
+
+    /** @brief The bits of the standard interfaces in the set, by ID */
+    uint8_t standard() const
+    {
+        return shared == nullptr ? 0 : shared->standard;
+    }
+
+    /** @brief The interfaces in the set that aren't standard ones */
+    std::span<const NameId> named() const
+    {
+        if (shared == nullptr)
+        {
+            return {};
+        }
+        return shared->ids;
+    }
+
+    /** @brief True if the set is the standard interfaces and nothing else,
+     *         as on a path that only has children
+     */
+    bool onlyStandard() const
+    {
+        return standard() == allStandardInterfaces && named().empty();
+    }
+
+    bool contains(NameId id) const;
+
+    /** @brief Get this set with an interface added */
+    InterfaceIds insert(NameId id) const;
+
+    /** @brief Get this set with interfaces added
+     *
+     * @param[in] ids - Interface IDs, sorted and without duplicates
+     */
+    InterfaceIds insert(std::span<const NameId> ids) const;
+
+    /** @brief Get this set with an interface removed */
+    InterfaceIds erase(NameId id) const;
+
+    void swap(InterfaceIds& other) noexcept
+    {
+        std::swap(shared, other.shared);
+    }
+
+    // Equal sets are always shared, so comparing them is cheap
+    friend bool operator==(const InterfaceIds& lhs, const InterfaceIds& rhs)
+    {
+        return lhs.shared == rhs.shared;
+    }
+
+  private:
+    friend class InterfaceSetPool;
+
+    struct Shared
+    {
+        size_t refs;
+        size_t hash;
+        uint8_t standard;
+        // Sorted, and without the standard interfaces
+        std::vector<NameId> ids;
+    };
+
+    static InterfaceIds intern(uint8_t standard, std::vector<NameId>&& ids);
+    void release();
+
+    // Null for the empty set
+    Shared* shared = nullptr;
+};
+
+/** @brief How much sharing of interface sets is going on */
+struct InterfaceSetStats
+{
+    // The number of distinct sets stored
+    size_t sets = 0;
+    // The number of connections on paths that refer to them
+    size_t references = 0;
+    // The number of interface IDs stored, not counting standard ones
+    size_t storedIds = 0;
+    // The number of interface IDs there would be without sharing
+    size_t referencedIds = 0;
+};
+
+/** @brief Get the sharing stats of all interface sets */
+InterfaceSetStats interfaceSetStats();
+
+/** @brief The number of connections a path holds without an allocation.
+ *
+ * Nearly every path has one connection, or two when the mapper also has
+ * the association interface there.
+ */
+constexpr size_t inlineConnections = 2;
+
+/** @brief The connections on a path, sorted by ID */
+using ConnectionIds = boost::container::flat_map<
+    NameId, InterfaceIds, std::less<>,
+    boost::container::small_vector<std::pair<NameId, InterfaceIds>,
+                                   inlineConnections>>;
+
+/** @brief Find the interfaces of a connection
+ *
+ * @param[in] connections - The connections on a path
+ * @param[in] connection  - The connection name
+ *
+ * @return The interfaces, or nullptr if the connection isn't there
+ */
+const InterfaceIds* findInterfaces(const ConnectionIds& connections,
+                                   std::string_view connection);
+
+/** @brief Check if a set of interfaces contains an interface name */
+bool containsInterface(const InterfaceIds& interfaces,
+                       std::string_view interface);
+
+/** @brief Convert interface IDs to the names used in query replies */
+InterfaceNames toInterfaceNames(const InterfaceIds& interfaces);
+
+/** @brief Convert connection IDs to the names used in query replies */
+ConnectionNames toConnectionNames(const ConnectionIds& connections);
+
+/** @brief The interface filter of a query, translated to name IDs.
+ *
+ * Names that were never interned can't be on any path, so they are left
+ * out.  The filter still isn't empty if all of its names were left out,
+ * it just doesn't match anything.
+ */
+class InterfaceFilter
+{
+  public:
+    explicit InterfaceFilter(const std::vector<std::string>& interfaces);
+
+    /** @brief True if the query didn't ask for any interfaces */
+    bool empty() const
+    {
+        return !filtered;
+    }
+
+    /** @brief True if any of the filter interfaces are in the set */
+    bool intersects(const InterfaceIds& interfaces) const;
+
+    /** @brief True if the filter is empty or intersects the set */
+    bool matches(const InterfaceIds& interfaces) const
+    {
+        return empty() || intersects(interfaces);
+    }
+
+    /** @brief The IDs of the filter interfaces, sorted */
+    const std::vector<NameId>& ids() const
+    {
+        return interfaceIds;
+    }
+
+    /** @brief The bits of the standard interfaces in the filter */
+    uint8_t standard() const
+    {
+        return standardIds;
+    }
+
+  private:
+    std::vector<NameId> interfaceIds;
+    uint8_t standardIds = 0;
+    bool filtered;
+};
+
+/** @brief One node of the object path tree.
+ *
+ * There is a node for every prefix of every object path in the interface
+ * map, keyed by path segment.  The root node is the empty path, and the
+ * path "/" is a child of the root with an empty segment.  Nodes for
+ * prefixes that are not themselves on D-Bus have a null entry.
+ *
+ * Object path segments only contain characters that sort after '/', so
+ * walking the children in order visits paths in the same order as the
+ * interface map itself.
+ */
+struct PathNode
+{
+    PathNode() = default;
+    PathNode(PathNode* parentNode, std::string_view name) :
+        parent(parentNode), segment(name)
+    {}
+
+    PathNode(const PathNode&) = delete;
+    PathNode(PathNode&&) = delete;
+    PathNode& operator=(const PathNode&) = delete;
+    PathNode& operator=(PathNode&&) = delete;
+    ~PathNode() = default;
+
+    PathNode* parent = nullptr;
+    std::string segment;
+
+    // Keys point into the segment of the child they map to
+    boost::container::flat_map<std::string_view, std::unique_ptr<PathNode>>
+        children;
+
+    // The interface map element for this path, if there is one
+    const std::pair<const PathAtom, ConnectionIds>* entry = nullptr;
+
+    // The number of interface map elements at or below this node
+    size_t count = 0;
+
+    // The number of paths below this node each connection is on
+    boost::container::flat_map<NameId, size_t> connectionsBelow;
+
+    // Changed whenever the interface map changes at or below this node.
+    // Generations are never reused within a map, even by a new node.
+    uint64_t generation = 0;
+};
+
+/** @brief InterfaceMapType is the underlying datastructure the mapper uses.
+ *
+ * The 3 levels of map are
+ * object paths
+ *   connection names
+ *      interface names
+ *
+ * Connection and interface names are stored as IDs from nameTable(), and
+ * only turned back into strings when a query reply is built.
+ *
+ * The object paths are also indexed by a tree of path segments, so that
+ * subtree queries only visit the part of the tree below the requested
+ * path, by interface name, so that queries for an interface only visit
+ * the paths that have it, and by connection name, so that a service
+ * leaving the bus only visits its own paths.  All modifications go through
+ * the member functions so the indexes stay in step with the map.
+ */
+class InterfaceMapType
+{
+  public:
+    using PathMap = std::map<PathAtom, ConnectionIds, std::less<>>;
+    using const_iterator = PathMap::const_iterator;
+
+    /** @brief Orders path tree nodes with an entry by their object path */
+    struct PathOrder
+    {
+        using is_transparent = void;
+
+        bool operator()(const PathNode* lhs, const PathNode* rhs) const
+        {
+            return lhs->entry->first < rhs->entry->first;
+        }
+
+        bool operator()(const PathNode* lhs, std::string_view rhs) const
+        {
+            return lhs->entry->first < rhs;
+        }
+
+        bool operator()(std::string_view lhs, const PathNode* rhs) const
+        {
+            return lhs < rhs->entry->first;
+        }
+    };
+
+    /** @brief A set of object paths in path order.
+     *
+     * There is one of these for every interface and connection, so every
+     * path is in several of them.  Most of each set is a frozen array of
+     * the paths, sorted, with a small tree of the paths added since the
+     * array was built.  A path removed from the array leaves a hole,
+     * which lookups step over.  Once the tree and the holes add up to an
+     * eighth of the array, both are merged into a new array.  Changes
+     * still cost a lookup plus amortized constant time, but a path in the
+     * array only takes a pointer instead of a tree node.
+     */
+    class PathSet
+    {
+      public:
+        /** @brief Constructor
+         *
+         * @param[in] resource - Where the array and tree are allocated
+         */
+        explicit PathSet(std::pmr::memory_resource* resource =
+                             std::pmr::get_default_resource()) :
+            frozen(resource), added(resource)
+        {}
+
+        /** @brief Visits the array and the tree in path order together */
+        class const_iterator
+        {
+          public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = const PathNode*;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+
+            const_iterator() = default;
+
+            reference operator*() const
+            {
+                return inFrozen ? *frozenIt : *addedIt;
+            }
+
+            const_iterator& operator++()
+            {
+                if (inFrozen)
+                {
+                    ++frozenIt;
+                }
+                else
+                {
+                    ++addedIt;
+                }
+                settle();
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator old = *this;
+                ++*this;
+                return old;
+            }
+
+            friend bool operator==(const const_iterator& lhs,
+                                   const const_iterator& rhs)
+            {
+                return lhs.frozenIt == rhs.frozenIt &&
+                       lhs.addedIt == rhs.addedIt;
+            }
+
+          private:
+            friend class PathSet;
+
+            using FrozenIt =
+                std::pmr::vector<const PathNode*>::const_iterator;
+            using AddedIt =
+                std::pmr::set<const PathNode*, PathOrder>::const_iterator;
+
+            const_iterator(FrozenIt frozen, FrozenIt frozenLast, AddedIt added,
+                           AddedIt addedLast) :
+                frozenIt(frozen), frozenEnd(frozenLast), addedIt(added),
+                addedEnd(addedLast)
+            {
+                settle();
+            }
+
+            // Skip holes, and pick whichever of the two is first
+            void settle()
+            {
+                while (frozenIt != frozenEnd && *frozenIt == nullptr)
+                {
+                    ++frozenIt;
+                }
+                inFrozen = frozenIt != frozenEnd &&
+                           (addedIt == addedEnd ||
+                            PathOrder()(*frozenIt, *addedIt));
+            }
+
+            FrozenIt frozenIt;
+            FrozenIt frozenEnd;
+            AddedIt addedIt;
+            AddedIt addedEnd;
+            bool inFrozen = false;
+        };
+
+        const_iterator begin() const
+        {
+            return iteratorAt(0, added.begin());
+        }
+
+        const_iterator end() const
+        {
+            return iteratorAt(frozen.size(), added.end());
+        }
+
+        size_t size() const
+        {
+            return frozen.size() - holes + added.size();
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+        /** @brief Find the first path not before an object path */
+        const_iterator lower_bound(std::string_view path) const;
+
+        /** @brief Find the first path after an object path */
+        const_iterator upper_bound(std::string_view path) const;
+
+        /** @brief Add a path
+         *
+         * @return True if the path wasn't in the set
+         */
+        bool insert(const PathNode* node);
+
+        /** @brief Remove a path
+         *
+         * @return True if the path was in the set
+         */
+        bool erase(const PathNode* node);
+
+      private:
+        using Tree = std::pmr::set<const PathNode*, PathOrder>;
+
+        // Small sets are only ever the tree
+        static constexpr size_t minMerge = 32;
+
+        const_iterator iteratorAt(size_t frozenPos,
+                                  Tree::const_iterator addedPos) const
+        {
+            return const_iterator(
+                frozen.begin() + static_cast<std::ptrdiff_t>(frozenPos),
+                frozen.end(), addedPos, added.end());
+        }
+
+        template <typename Less>
+        size_t frozenBound(Less less) const;
+        size_t findFrozen(const PathNode* node) const;
+        void mergeIfNeeded();
+
+        // Null where a path was removed
+        std::pmr::vector<const PathNode*> frozen;
+        size_t holes = 0;
+        Tree added;
+    };
+
+    /** @brief Orders path tree nodes with an entry by their last segment,
+     *         then by their object path
+     */
+    struct LeafOrder
+    {
+        using is_transparent = void;
+
+        bool operator()(const PathNode* lhs, const PathNode* rhs) const
+        {
+            if (lhs->segment != rhs->segment)
+            {
+                return lhs->segment < rhs->segment;
+            }
+            return lhs->entry->first < rhs->entry->first;
+        }
+
+        bool operator()(const PathNode* lhs, std::string_view rhs) const
+        {
+            return lhs->segment < rhs;
+        }
+
+        bool operator()(std::string_view lhs, const PathNode* rhs) const
+        {
+            return lhs < rhs->segment;
+        }
+    };
+
+    /** @brief A set of object paths, grouped by their last segment */
+    using LeafSet = std::set<const PathNode*, LeafOrder>;
+
+    /** @brief The object path / connections pair returned by queries */
+    using value_type = std::pair<std::string, ConnectionNames>;
+
+    InterfaceMapType();
+    InterfaceMapType(std::initializer_list<value_type> init);
+
+    InterfaceMapType(const InterfaceMapType&) = delete;
+    InterfaceMapType(InterfaceMapType&&) = default;
+    InterfaceMapType& operator=(const InterfaceMapType&) = delete;
+    InterfaceMapType& operator=(InterfaceMapType&&) = default;
+    ~InterfaceMapType() = default;
+
+    const_iterator begin() const
+    {
+        return paths.begin();
+    }
+
+    const_iterator end() const
+    {
+        return paths.end();
+    }
+
+    const_iterator find(std::string_view path) const
+    {
+        return paths.find(path);
+    }
+
+    bool contains(std::string_view path) const
+    {
+        return paths.contains(path);
+    }
+
+    size_t size() const
+    {
+        return paths.size();
+    }
+
+    bool empty() const
+    {
+        return paths.empty();
+    }
+
+    /** @brief Add an object path without any connections
+     *
+     * @param[in] path - The object path
+     *
+     * @return The entry for the path, and true if it was newly added
+     */
+    std::pair<const_iterator, bool> emplace(const std::string& path);
+
+    /** @brief Add an object path without any connections, near an entry
+     *
+     * This is emplace() for paths added in path order, which are found in
+     * constant time when they go right before hint.
+     *
+     * @param[in] hint - The entry the path probably goes before
+     * @param[in] path - The object path
+     *
+     * @return The entry for the path, and true if it was newly added
+     */
+    std::pair<const_iterator, bool> emplace(const_iterator hint,
+                                            std::string_view path);
+
+    /** @brief Add a connection without any interfaces to an object path
+     *
+     * @param[in] path       - The object path entry
+     * @param[in] connection - The connection name
+     *
+     * @return True if the connection was not already on the path
+     */
+    bool addConnection(const_iterator path, std::string_view connection);
+
+    /** @brief Add an interface of a connection to an object path
+     *
+     * @param[in] path       - The object path entry
+     * @param[in] connection - The connection name
+     * @param[in] interface  - The interface name
+     */
+    void addInterface(const_iterator path, std::string_view connection,
+                      std::string_view interface);
+
+    /** @brief Add interfaces of a connection to an object path
+     *
+     * The same as addInterface() for each of the interfaces, except that
+     * the interface set of the connection is only rebuilt once.
+     *
+     * @param[in] path       - The object path entry
+     * @param[in] connection - The connection name
+     * @param[in] interfaces - Interface IDs, sorted and without duplicates
+     */
+    void addInterfaces(const_iterator path, std::string_view connection,
+                       std::span<const NameId> interfaces);
+
+    /** @brief Remove an interface of a connection from an object path
+     *
+     * If the connection has no interfaces left on the path afterwards, the
+     * connection is removed from the path as well.
+     *
+     * @param[in] path       - The object path entry
+     * @param[in] connection - The connection name
+     * @param[in] interface  - The interface name
+     *
+     * @return True if the connection was removed from the path
+     */
+    bool removeInterface(const_iterator path, std::string_view connection,
+                         std::string_view interface);
+
+    /** @brief Remove a connection and all of its interfaces from a path
+     *
+     * @param[in] path       - The object path entry
+     * @param[in] connection - The connection name
+     *
+     * @return True if the connection was on the path
+     */
+    bool removeConnection(const_iterator path, std::string_view connection);
+
+    /** @brief Remove a connection from every path it is on, for a service
+     *         that left the bus
+     *
+     * Paths without any connections left are erased.  The index of the
+     * connection's paths is the only data of it that isn't shared with
+     * other connections, so it is allocated from a pool of the connection,
+     * which is released here at once instead of path by path.
+     *
+     * @param[in] connection - The connection name
+     */
+    void removeConnection(std::string_view connection);
+
+    /** @brief Remove an object path
+     *
+     * @param[in] path - The object path entry
+     *
+     * @return The entry following the removed one
+     */
+    const_iterator erase(const_iterator path);
+
+    /** @brief Find the path tree node of an object path
+     *
+     * @param[in] path - The object path, without a trailing '/'
+     *
+     * @return The node, or nullptr if no stored path is at or below it
+     */
+    const PathNode* findNode(std::string_view path) const;
+
+    /** @brief Find the stored object paths above an object path
+     *
+     * The empty path and "/" are above every other path.
+     *
+     * @param[in] path - The object path, without a trailing '/'
+     *
+     * @return The path tree nodes of the stored ancestors, in path order
+     */
+    std::vector<const PathNode*> findAncestors(std::string_view path) const;
+
+    /** @brief Call fn with every entry below a path tree node
+     *
+     * Entries are visited in object path order.  Only the part of the tree
+     * at most depth levels below node is walked.
+     *
+     * @param[in] node  - The node to start at, which is not visited itself
+     * @param[in] depth - The number of levels to descend, must be positive
+     * @param[in] fn    - Called with each InterfaceMapType element
+     */
+    template <typename Fn>
+    static void forEachDescendant(const PathNode& node, int32_t depth, Fn&& fn)
+    {
+        for (const auto& child : node.children)
+        {
+            if (child.second->entry != nullptr)
+            {
+                fn(*child.second->entry);
+            }
+            if (depth > 1)
+            {
+                forEachDescendant(*child.second, depth - 1, fn);
+            }
+        }
+    }
+
+    /** @brief Call fn with every entry below a path tree node that has at
+     *         least one of the interfaces on any connection
+     *
+     * When the interfaces are on fewer paths than there are below node,
+     * only the paths with the interfaces are visited.  Otherwise this is
+     * the same as the unfiltered walk, and fn has to check the interfaces
+     * itself.  Entries are visited in object path order.
+     *
+     * @param[in] node       - The node to start at, which is not visited
+     * @param[in] path       - The object path of node
+     * @param[in] depth      - The number of levels to descend, positive
+     * @param[in] interfaces - The interface filter
+     * @param[in] fn         - Called with each InterfaceMapType element
+     */
+    template <typename Fn>
+    void forEachDescendant(const PathNode& node, std::string_view path,
+                           int32_t depth, const InterfaceFilter& interfaces,
+                           Fn&& fn) const
+    {
+        std::vector<const PathNode*> candidates;
+        if (findCandidates(node, path, depth, interfaces, candidates))
+        {
+            for (const PathNode* candidate : candidates)
+            {
+                fn(*candidate->entry);
+            }
+            return;
+        }
+        forEachDescendant(node, depth, fn);
+    }
+
+    /** @brief Find the next entries below a path tree node that have at
+     *         least one of the interfaces on any connection
+     *
+     * This is one page of forEachDescendant(), starting after an object
+     * path instead of at the start.  Only about as much of the tree or
+     * interface index as the page covers is visited, and the object path
+     * to start after doesn't have to be in the map any more.
+     *
+     * @param[in] node       - The node to start at, which is not included
+     * @param[in] path       - The object path of node
+     * @param[in] depth      - The number of levels to descend, positive
+     * @param[in] interfaces - The interface filter
+     * @param[in] after      - The object path to start after, which must
+     *                         be below path.  Empty to start at the first.
+     * @param[in] limit      - The most entries to return
+     *
+     * @return The path tree nodes of the entries, in path order
+     */
+    std::vector<const PathNode*> findDescendants(
+        const PathNode& node, std::string_view path, int32_t depth,
+        const InterfaceFilter& interfaces, std::string_view after,
+        size_t limit) const;
+
+    /** @brief Find the object paths that have an interface
+     *
+     * The standard interfaces are on nearly every path, so they aren't
+     * indexed, and a filter with one of them always walks the path tree.
+     *
+     * @param[in] interface - The interface name
+     *
+     * @return The paths with the interface on any connection, or nullptr
+     *         if no path has it or it is a standard interface
+     */
+    const PathSet* findInterface(std::string_view interface) const;
+
+    /** @brief Find the object paths that have an interface ID */
+    const PathSet* findInterface(NameId interface) const;
+
+    /** @brief Find the object paths a connection is on
+     *
+     * @param[in] connection - The connection name
+     *
+     * @return The paths the connection is on, or nullptr if there are none
+     */
+    const PathSet* findConnection(std::string_view connection) const;
+
+    /** @brief Check if a connection is on any path below an object path
+     *
+     * This is a lookup of a count kept per path tree node, so it doesn't
+     * depend on how many paths there are below the path.
+     *
+     * @param[in] path       - The object path entry
+     * @param[in] connection - The connection name
+     *
+     * @return True if the connection is on a descendant of the path
+     */
+    bool hasConnectionBelow(const_iterator path,
+                            std::string_view connection) const;
+
+    /** @brief Find the object paths that end in a segment
+     *
+     * @param[in] leaf - The last segment of the paths
+     *
+     * @return The path tree nodes of the paths, in path order
+     */
+    std::ranges::subrange<LeafSet::const_iterator>
+        findLeaf(std::string_view leaf) const
+    {
+        auto [first, last] = leafPaths.equal_range(leaf);
+        return {first, last};
+    }
+
+  private:
+    /** @brief The index of one connection's paths, in a pool of its own */
+    struct ConnectionPaths
+    {
+        ConnectionPaths() : paths(&pool) {}
+
+        std::pmr::unsynchronized_pool_resource pool;
+        PathSet paths;
+    };
+
+    PathMap::iterator mutableIterator(const_iterator it)
+    {
+        return paths.erase(it, it);
+    }
+
+    PathNode& insertNode(std::string_view path);
+    void releaseNode(std::string_view path);
+    void touch(const_iterator path);
+
+    void indexInterface(const_iterator path, NameId interface);
+    void unindexInterface(const_iterator path, NameId interface);
+    void indexConnection(PathNode& node, NameId connection);
+    void unindexConnection(PathNode& node, NameId connection);
+
+    size_t findIndexes(const InterfaceFilter& interfaces,
+                       std::vector<const PathSet*>& indexes) const;
+
+    bool findCandidates(const PathNode& node, std::string_view path,
+                        int32_t depth, const InterfaceFilter& interfaces,
+                        std::vector<const PathNode*>& candidates) const;
+
+    PathMap paths;
+    std::unique_ptr<PathNode> tree;
+    uint64_t lastGeneration = 0;
+
+    // Map of interface ID to the paths that have it on any connection
+    boost::container::flat_map<NameId, PathSet> interfacePaths;
+
+    // Map of connection ID to the paths it is on
+    boost::container::flat_map<NameId, std::unique_ptr<ConnectionPaths>>
+        connectionPaths;
+
+    // Every path, grouped by its last segment
+    LeafSet leafPaths;
+};
@@ -1,6 +1,12 @@
 #include "associations.hpp"
+#include "bulk_load.hpp"
+#include "direct_methods.hpp"
 #include "handler.hpp"
+#include "interface_map.hpp"
+#include "miss_cache.hpp"
 #include "processing.hpp"
+#include "query_cache.hpp"
+#include "reply_cache.hpp"
 #include "types.hpp"
 
 #include <tinyxml2.h>
@@ -10,8 +16,10 @@
 #include <boost/container/flat_map.hpp>
 #include <sdbusplus/asio/connection.hpp>
 #include <sdbusplus/asio/object_server.hpp>
+#include <sdbusplus/server/interface.hpp>
 #include <xyz/openbmc_project/Common/error.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <exception>
 #include <iomanip>
@@ -19,8 +27,13 @@
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 static AssociationMaps associationMaps;
+static MissCache missCache(missCacheEntries);
+
+// The scans in progress, by service name
+static boost::container::flat_map<std::string, BulkLoad*> bulkLoads;
 
 static void updateOwners(
     sdbusplus::asio::connection* conn,
@@ -69,7 +82,8 @@ struct InProgressIntrospect
     InProgressIntrospect(
         sdbusplus::asio::connection* systemBusConnection,
         boost::asio::io_context& ioContext,
-        const std::string& introspectProcessName, AssociationMaps& am
+        const std::string& introspectProcessName, AssociationMaps& am,
+        InterfaceMapType& map, sdbusplus::asio::object_server& server
 #ifdef MAPPER_ENABLE_DEBUG
         ,
         std::shared_ptr<std::chrono::time_point<std::chrono::steady_clock>>
@@ -77,17 +91,27 @@ struct InProgressIntrospect
 #endif
         ) :
         systemBus(systemBusConnection), io(ioContext),
-        processName(introspectProcessName), assocMaps(am)
+        processName(introspectProcessName), assocMaps(am), interfaceMap(map),
+        objectServer(server), bulkLoad(introspectProcessName)
 #ifdef MAPPER_ENABLE_DEBUG
         ,
         globalStartTime(std::move(globalIntrospectStartTime)),
         processStartTime(std::chrono::steady_clock::now())
 #endif
-    {}
+    {
+        bulkLoads[processName] = &bulkLoad;
+    }
     ~InProgressIntrospect()
     {
         try
         {
+            auto staged = bulkLoads.find(processName);
+            if (staged != bulkLoads.end() && staged->second == &bulkLoad)
+            {
+                bulkLoads.erase(staged);
+            }
+            commitStaged();
+
             sendIntrospectionCompleteSignal(systemBus, processName);
 #ifdef MAPPER_ENABLE_DEBUG
             std::chrono::duration<float> diff =
@@ -102,6 +126,19 @@ struct InProgressIntrospect
                 diff = std::chrono::steady_clock::now() - *globalStartTime;
                 std::cout << "Total scan took " << diff.count()
                           << " seconds to complete\n";
+
+                InterfaceSetStats sets = interfaceSetStats();
+                std::cout << sets.references << " connections share "
+                          << sets.sets << " interface sets, storing "
+                          << sets.storedIds << " of " << sets.referencedIds
+                          << " interface IDs\n";
+
+                const MissCacheStats& misses = missCache.stats();
+                std::cout << misses.hits
+                          << " GetObject lookups were answered by the miss "
+                             "cache during the scan, "
+                          << misses.invalidations
+                          << " missed paths were added since\n";
             }
 #endif
         }
@@ -119,10 +156,28 @@ struct InProgressIntrospect
             std::terminate();
         }
     }
+
+    // Add what the scan has staged so far to the map
+    void commitStaged()
+    {
+        std::vector<std::string> added = bulkLoad.commit(interfaceMap);
+        for (const std::string& path : added)
+        {
+            missCache.erase(path);
+        }
+        // Associations between paths of the service can only be completed
+        // once both ends are in the map
+        checkIfPendingAssociations(io, added, interfaceMap, assocMaps,
+                                   objectServer);
+    }
+
     sdbusplus::asio::connection* systemBus;
     boost::asio::io_context& io;
     std::string processName;
     AssociationMaps& assocMaps;
+    InterfaceMapType& interfaceMap;
+    sdbusplus::asio::object_server& objectServer;
+    BulkLoad bulkLoad;
 #ifdef MAPPER_ENABLE_DEBUG
     std::shared_ptr<std::chrono::time_point<std::chrono::steady_clock>>
         globalStartTime;
@@ -206,7 +261,7 @@ static void doIntrospect(
                 std::cerr << "XML document did not contain any data\n";
                 return;
             }
-            auto& thisPathMap = interfaceMap[path];
+            std::vector<std::string_view> interfaces;
             tinyxml2::XMLElement* pElement =
                 pRoot->FirstChildElement("interface");
             while (pElement != nullptr)
@@ -217,7 +272,7 @@ static void doIntrospect(
                     continue;
                 }
 
-                thisPathMap[transaction->processName].emplace(ifaceName);
+                interfaces.emplace_back(ifaceName);
 
                 if (std::strcmp(ifaceName, assocDefsInterface) == 0)
                 {
@@ -228,10 +283,12 @@ static void doIntrospect(
                 pElement = pElement->NextSiblingElement("interface");
             }
 
-            // Check if this new path has a pending association that can
-            // now be completed.
-            checkIfPendingAssociation(io, path, interfaceMap,
-                                      transaction->assocMaps, objectServer);
+            // The path is added to the map with the rest of its batch
+            transaction->bulkLoad.add(path, interfaces);
+            if (transaction->bulkLoad.size() >= bulkLoadBatchPaths)
+            {
+                transaction->commitStaged();
+            }
 
             pElement = pRoot->FirstChildElement("node");
             while (pElement != nullptr)
@@ -269,7 +326,8 @@ static void startNewIntrospect(
     {
         std::shared_ptr<InProgressIntrospect> transaction =
             std::make_shared<InProgressIntrospect>(
-                systemBus, io, processName, assocMaps
+                systemBus, io, processName, assocMaps, interfaceMap,
+                objectServer
 #ifdef MAPPER_ENABLE_DEBUG
                 ,
                 globalStartTime
@@ -323,68 +381,6 @@ static void doListNames(
         "ListNames");
 }
 
-// Remove parents of the passed in path that:
-// 1) Only have the 3 default interfaces on them
-//    - Means D-Bus created these, not application code,
-//      with the Properties, Introspectable, and Peer ifaces
-// 2) Have no other child for this owner
-static void removeUnneededParents(const std::string& objectPath,
-                                  const std::string& owner,
-                                  InterfaceMapType& interfaceMap)
-{
-    auto parent = objectPath;
-
-    while (true)
-    {
-        auto pos = parent.find_last_of('/');
-        if ((pos == std::string::npos) || (pos == 0))
-        {
-            break;
-        }
-        parent = parent.substr(0, pos);
-
-        auto parentIt = interfaceMap.find(parent);
-        if (parentIt == interfaceMap.end())
-        {
-            break;
-        }
-
-        auto ifacesIt = parentIt->second.find(owner);
-        if (ifacesIt == parentIt->second.end())
-        {
-            break;
-        }
-
-        if (ifacesIt->second.size() != 3)
-        {
-            break;
-        }
-
-        auto childPath = parent + '/';
-
-        // Remove this parent if there isn't a remaining child on this owner
-        auto child = std::find_if(
-            interfaceMap.begin(), interfaceMap.end(),
-            [&owner, &childPath](const auto& entry) {
-                return entry.first.starts_with(childPath) &&
-                       (entry.second.find(owner) != entry.second.end());
-            });
-
-        if (child == interfaceMap.end())
-        {
-            parentIt->second.erase(ifacesIt);
-            if (parentIt->second.empty())
-            {
-                interfaceMap.erase(parentIt);
-            }
-        }
-        else
-        {
-            break;
-        }
-    }
-}
-
 int main()
 {
     boost::asio::io_context io;
@@ -400,6 +396,7 @@ int main()
     });
 
     InterfaceMapType interfaceMap;
+    ReplyCache replyCache(interfaceMap, queryCacheEntries, queryCacheBytes);
     boost::container::flat_map<std::string, std::string> nameOwners;
 
     auto nameChangeHandler = [&interfaceMap, &io, &nameOwners, &server,
@@ -418,6 +415,13 @@ int main()
 
         if (!oldOwner.empty())
         {
+            // Nothing its scan staged is on the bus any more
+            auto staged = bulkLoads.find(name);
+            if (staged != bulkLoads.end())
+            {
+                staged->second->cancel();
+                bulkLoads.erase(staged);
+            }
             processNameChangeDelete(io, nameOwners, name, oldOwner,
                                     interfaceMap, associationMaps, server);
         }
@@ -460,8 +464,9 @@ int main()
         }
         if (needToIntrospect(wellKnown))
         {
-            processInterfaceAdded(io, interfaceMap, objPath, interfacesAdded,
-                                  wellKnown, associationMaps, server);
+            processInterfaceAdded(io, interfaceMap, missCache, objPath,
+                                  interfacesAdded, wellKnown, associationMaps,
+                                  server);
         }
     };
 
@@ -475,21 +480,32 @@ int main()
         sdbusplus::message::object_path objPath;
         std::vector<std::string> interfacesRemoved;
         message.read(objPath, interfacesRemoved);
-        auto connectionMap = interfaceMap.find(objPath.str);
-        if (connectionMap == interfaceMap.end())
+        std::string sender;
+        if (!getWellKnown(nameOwners, message.get_sender(), sender))
         {
             return;
         }
 
-        std::string sender;
-        if (!getWellKnown(nameOwners, message.get_sender(), sender))
+        // The path may only be staged by a scan that isn't done yet
+        auto staged = bulkLoads.find(sender);
+        bool wasStaged = staged != bulkLoads.end() &&
+                         staged->second->remove(objPath.str, interfacesRemoved);
+
+        auto connectionMap = interfaceMap.find(objPath.str);
+        if (connectionMap == interfaceMap.end())
         {
+            if (wasStaged &&
+                std::ranges::find(interfacesRemoved, assocDefsInterface) !=
+                    interfacesRemoved.end())
+            {
+                removeAssociation(io, objPath.str, sender, server,
+                                  associationMaps);
+            }
             return;
         }
         for (const std::string& interface : interfacesRemoved)
         {
-            auto interfaceSet = connectionMap->second.find(sender);
-            if (interfaceSet == connectionMap->second.end())
+            if (findInterfaces(connectionMap->second, sender) == nullptr)
             {
                 continue;
             }
@@ -500,21 +516,17 @@ int main()
                                   associationMaps);
             }
 
-            interfaceSet->second.erase(interface);
-
-            if (interfaceSet->second.empty())
+            // If this was the last interface on this connection,
+            // the connection is erased as well
+            if (interfaceMap.removeInterface(connectionMap, sender, interface))
             {
-                // If this was the last interface on this connection,
-                // erase the connection
-                connectionMap->second.erase(interfaceSet);
-
                 // Instead of checking if every single path is the endpoint
                 // of an association that needs to be moved to pending,
                 // only check when the only remaining owner of this path is
                 // ourself, which would be because we still own the
                 // association path.
                 if ((connectionMap->second.size() == 1) &&
-                    (connectionMap->second.begin()->first ==
+                    (nameTable()[connectionMap->second.begin()->first] ==
                      "xyz.openbmc_project.ObjectMapper"))
                 {
                     // Remove the 2 association D-Bus paths and move the
@@ -573,31 +585,6 @@ int main()
         server.add_interface("/xyz/openbmc_project/object_mapper",
                              "xyz.openbmc_project.ObjectMapper");
 
-    iface->register_method(
-        "GetAncestors", [&interfaceMap](std::string& reqPath,
-                                        std::vector<std::string>& interfaces) {
-            return getAncestors(interfaceMap, reqPath, interfaces);
-        });
-
-    iface->register_method(
-        "GetObject", [&interfaceMap](const std::string& path,
-                                     std::vector<std::string>& interfaces) {
-            return getObject(interfaceMap, path, interfaces);
-        });
-
-    iface->register_method(
-        "GetSubTree", [&interfaceMap](std::string& reqPath, int32_t depth,
-                                      std::vector<std::string>& interfaces) {
-            return getSubTree(interfaceMap, reqPath, depth, interfaces);
-        });
-
-    iface->register_method(
-        "GetSubTreePaths",
-        [&interfaceMap](std::string& reqPath, int32_t depth,
-                        std::vector<std::string>& interfaces) {
-            return getSubTreePaths(interfaceMap, reqPath, depth, interfaces);
-        });
-
     iface->register_method(
         "GetAssociatedSubTree",
         [&interfaceMap](const sdbusplus::message::object_path& associationPath,
@@ -618,29 +605,111 @@ int main()
                                              interfaces);
         });
 
-    iface->register_method(
-        "GetAssociatedSubTreeById",
-        [&interfaceMap](const std::string& id, const std::string& objectPath,
-                        std::vector<std::string>& subtreeInterfaces,
-                        const std::string& association,
-                        std::vector<std::string>& endpointInterfaces) {
-            return getAssociatedSubTreeById(interfaceMap, associationMaps, id,
-                                            objectPath, subtreeInterfaces,
-                                            association, endpointInterfaces);
+    iface->initialize();
+
+    // Mapper methods that aren't part of the ObjectMapper interface in
+    // phosphor-dbus-interfaces.  They are defined in the yaml directory.
+    std::shared_ptr<sdbusplus::asio::dbus_interface> extensionsIface =
+        server.add_interface("/xyz/openbmc_project/object_mapper",
+                             "xyz.openbmc_project.ObjectMapper.Extensions");
+
+    extensionsIface->register_method(
+        "GetSubTreePage",
+        [&interfaceMap](std::string& reqPath, int32_t depth,
+                        std::vector<std::string>& interfaces, uint32_t pageSize,
+                        const std::string& token) {
+            return getSubTreePage(interfaceMap, reqPath, depth, interfaces,
+                                  pageSize, token);
         });
 
-    iface->register_method(
-        "GetAssociatedSubTreePathsById",
-        [&interfaceMap](const std::string& id, const std::string& objectPath,
-                        std::vector<std::string>& subtreeInterfaces,
-                        const std::string& association,
-                        std::vector<std::string>& endpointInterfaces) {
-            return getAssociatedSubTreePathsById(
-                interfaceMap, associationMaps, id, objectPath,
-                subtreeInterfaces, association, endpointInterfaces);
+    extensionsIface->register_method(
+        "GetSubTreePathsPage",
+        [&interfaceMap](std::string& reqPath, int32_t depth,
+                        std::vector<std::string>& interfaces, uint32_t pageSize,
+                        const std::string& token) {
+            return getSubTreePathsPage(interfaceMap, reqPath, depth,
+                                       interfaces, pageSize, token);
         });
 
-    iface->initialize();
+    extensionsIface->register_method(
+        "GetObjectsByService",
+        [&interfaceMap, &nameOwners](const std::string& service,
+                                     std::vector<std::string>& interfaces) {
+            // Paths are stored by well-known name
+            std::string wellKnown;
+            if (!getWellKnown(nameOwners, service, wellKnown))
+            {
+                return ServiceObjects();
+            }
+            return getObjectsByService(interfaceMap, wellKnown, interfaces);
+        });
+
+    extensionsIface->register_method(
+        "GetSubTreeByPattern",
+        [&interfaceMap](const std::string& pattern,
+                        std::vector<std::string>& interfaces) {
+            return getSubTreeByPattern(interfaceMap, pattern, interfaces);
+        });
+
+    extensionsIface->register_method(
+        "GetSubTreeCompact",
+        [&interfaceMap](std::string& reqPath, int32_t depth,
+                        std::vector<std::string>& interfaces,
+                        uint32_t projection) {
+            return getSubTreeCompact(interfaceMap, reqPath, depth, interfaces,
+                                     projection);
+        });
+
+    extensionsIface->register_method(
+        "ExecuteBatch", [&interfaceMap](std::vector<BatchQuery>& queries) {
+            return executeBatch(interfaceMap, associationMaps, missCache,
+                                queries);
+        });
+
+    extensionsIface->initialize();
+
+    DirectMethods directMethods(interfaceMap, associationMaps, replyCache,
+                                missCache);
+    sdbusplus::server::interface_t directIface(
+        static_cast<sdbusplus::bus_t&>(*systemBus),
+        "/xyz/openbmc_project/object_mapper",
+        "xyz.openbmc_project.ObjectMapper", DirectMethods::vtable,
+        &directMethods);
+
+    std::shared_ptr<sdbusplus::asio::dbus_interface> cacheIface =
+        server.add_interface("/xyz/openbmc_project/object_mapper",
+                             "xyz.openbmc_project.ObjectMapper.QueryCache");
+
+    cacheIface->register_property_r<uint64_t>(
+        "Hits", 0, sdbusplus::vtable::property_::none,
+        [&replyCache](const auto&) { return replyCache.stats().hits; });
+    cacheIface->register_property_r<uint64_t>(
+        "Misses", 0, sdbusplus::vtable::property_::none,
+        [&replyCache](const auto&) { return replyCache.stats().misses; });
+    cacheIface->register_property_r<uint64_t>(
+        "Evictions", 0, sdbusplus::vtable::property_::none,
+        [&replyCache](const auto&) { return replyCache.stats().evictions; });
+    cacheIface->register_property_r<uint64_t>(
+        "Uncached", 0, sdbusplus::vtable::property_::none,
+        [&replyCache](const auto&) { return replyCache.stats().uncached; });
+
+    cacheIface->initialize();
+
+    std::shared_ptr<sdbusplus::asio::dbus_interface> missIface =
+        server.add_interface("/xyz/openbmc_project/object_mapper",
+                             "xyz.openbmc_project.ObjectMapper.MissCache");
+
+    missIface->register_property_r<uint64_t>(
+        "Hits", 0, sdbusplus::vtable::property_::none,
+        [](const auto&) { return missCache.stats().hits; });
+    missIface->register_property_r<uint64_t>(
+        "Invalidations", 0, sdbusplus::vtable::property_::none,
+        [](const auto&) { return missCache.stats().invalidations; });
+    missIface->register_property_r<uint64_t>(
+        "Evictions", 0, sdbusplus::vtable::property_::none,
+        [](const auto&) { return missCache.stats().evictions; });
+
+    missIface->initialize();
 
     boost::asio::post(io, [&]() {
         doListNames(io, interfaceMap, systemBus.get(), nameOwners,
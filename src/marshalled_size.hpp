@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/** @brief The size of values in a D-Bus message body.
+ *
+ * These follow the marshalling rules of the D-Bus specification, so a
+ * result's reply size can be known without a bus connection to build the
+ * message on.  Only the types mapper replies are made of are covered.
+ */
+namespace marshalled
+{
+
+inline size_t align(size_t offset, size_t alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+concept Array = std::ranges::range<T> &&
+                !std::is_convertible_v<const T&, std::string_view>;
+
+template <typename T>
+concept Struct = requires { std::tuple_size<T>::value; };
+
+/** @brief The alignment of a type's values */
+template <typename T>
+constexpr size_t alignment()
+{
+    if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+    {
+        return sizeof(T);
+    }
+    else if constexpr (Struct<T>)
+    {
+        return 8;
+    }
+    else
+    {
+        // Strings, arrays and booleans
+        return 4;
+    }
+}
+
+template <typename T>
+    requires std::is_integral_v<T>
+size_t add(size_t offset, T value);
+size_t add(size_t offset, std::string_view value);
+template <Array T>
+size_t add(size_t offset, const T& value);
+template <Struct T>
+size_t add(size_t offset, const T& value);
+
+/** @brief Add the size of an integer to where it would start */
+template <typename T>
+    requires std::is_integral_v<T>
+size_t add(size_t offset, T /*value*/)
+{
+    constexpr size_t size = std::is_same_v<T, bool> ? 4 : sizeof(T);
+    return align(offset, alignment<T>()) + size;
+}
+
+/** @brief Add the size of a string: its length, bytes and terminator */
+inline size_t add(size_t offset, std::string_view value)
+{
+    return align(offset, 4) + 4 + value.size() + 1;
+}
+
+/** @brief Add the size of an array.  Its elements are aligned even when
+ *         there aren't any.
+ */
+template <Array T>
+size_t add(size_t offset, const T& value)
+{
+    using Element = std::remove_cvref_t<std::ranges::range_value_t<T>>;
+    offset = align(align(offset, 4) + 4, alignment<Element>());
+    for (const auto& element : value)
+    {
+        offset = add(offset, element);
+    }
+    return offset;
+}
+
+/** @brief Add the size of a struct or dict entry */
+template <Struct T>
+size_t add(size_t offset, const T& value)
+{
+    offset = align(offset, 8);
+    std::apply(
+        [&offset](const auto&... members) {
+            ((offset = add(offset, members)), ...);
+        },
+        value);
+    return offset;
+}
+
+} // namespace marshalled
+
+/** @brief Get the size of a value as the body of a D-Bus message */
+template <typename T>
+size_t marshalledSize(const T& value)
+{
+    return marshalled::add(0, value);
+}
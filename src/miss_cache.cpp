@@ -0,0 +1,39 @@
+#include "miss_cache.hpp"
+
+bool MissCache::contains(std::string_view path)
+{
+    if (paths.empty() || !paths.contains(path))
+    {
+        return false;
+    }
+    counters.hits++;
+    return true;
+}
+
+void MissCache::insert(std::string_view path)
+{
+    if (capacity == 0 || paths.contains(path))
+    {
+        return;
+    }
+    if (paths.size() >= capacity)
+    {
+        counters.evictions += paths.size();
+        paths.clear();
+    }
+    paths.emplace(path);
+}
+
+void MissCache::erase(std::string_view path)
+{
+    if (paths.empty())
+    {
+        return;
+    }
+    auto it = paths.find(path);
+    if (it != paths.end())
+    {
+        paths.erase(it);
+        counters.invalidations++;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+constexpr size_t missCacheEntries = 1024;
+
+struct MissCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t invalidations = 0;
+    uint64_t evictions = 0;
+};
+
+/** @brief A bounded set of object paths that lookups didn't find.
+ *
+ * While services start, many clients poll GetObject for the same paths
+ * until their owners show up.  A path stays in the set until it is added
+ * to the interface map, so whatever adds paths has to erase them here.
+ * When the set is full it is cleared, since misses for paths that never
+ * show up shouldn't keep the ones being waited for out.
+ */
+class MissCache
+{
+  public:
+    /** @brief Constructor
+     *
+     * @param[in] maxEntries - The number of paths to keep
+     */
+    explicit MissCache(size_t maxEntries) : capacity(maxEntries) {}
+
+    /** @brief Check if a lookup of a path is known to miss
+     *
+     * @param[in] path - The object path
+     *
+     * @return True if the path was missed and hasn't been added since
+     */
+    bool contains(std::string_view path);
+
+    /** @brief Remember that a path isn't in the interface map
+     *
+     * @param[in] path - The object path
+     */
+    void insert(std::string_view path);
+
+    /** @brief Forget a path, because it was added to the interface map
+     *
+     * @param[in] path - The object path
+     */
+    void erase(std::string_view path);
+
+    const MissCacheStats& stats() const
+    {
+        return counters;
+    }
+
+    size_t size() const
+    {
+        return paths.size();
+    }
+
+  private:
+    struct PathHash
+    {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view path) const
+        {
+            return std::hash<std::string_view>{}(path);
+        }
+    };
+
+    size_t capacity;
+    std::unordered_set<std::string, PathHash, std::equal_to<>> paths;
+    MissCacheStats counters;
+};
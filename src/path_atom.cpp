@@ -0,0 +1,137 @@
+#include "path_atom.hpp"
+
+#include <unordered_set>
+
+// All of the distinct paths, keyed by their text
+class PathAtomPool
+{
+  public:
+    using Shared = PathAtom::Shared;
+
+    Shared* find(std::string_view path) const
+    {
+        auto it = paths.find(path);
+        return it == paths.end() ? nullptr : *it;
+    }
+
+    void insert(Shared* shared)
+    {
+        paths.emplace(shared);
+    }
+
+    void erase(Shared* shared)
+    {
+        paths.erase(shared);
+    }
+
+    PathAtomStats stats() const
+    {
+        PathAtomStats result;
+        result.paths = paths.size();
+        for (const Shared* shared : paths)
+        {
+            result.references += shared->refs;
+            result.storedChars += shared->path.size();
+            result.referencedChars += shared->refs * shared->path.size();
+        }
+        return result;
+    }
+
+  private:
+    struct Hash
+    {
+        using is_transparent = void;
+
+        size_t operator()(const Shared* shared) const
+        {
+            return std::hash<std::string_view>{}(shared->path);
+        }
+
+        size_t operator()(std::string_view path) const
+        {
+            return std::hash<std::string_view>{}(path);
+        }
+    };
+
+    struct Equal
+    {
+        using is_transparent = void;
+
+        bool operator()(const Shared* lhs, const Shared* rhs) const
+        {
+            return lhs == rhs;
+        }
+
+        bool operator()(std::string_view lhs, const Shared* rhs) const
+        {
+            return lhs == rhs->path;
+        }
+
+        bool operator()(const Shared* lhs, std::string_view rhs) const
+        {
+            return lhs->path == rhs;
+        }
+    };
+
+    std::unordered_set<Shared*, Hash, Equal> paths;
+};
+
+// Never destroyed.  Statics constructed before it, like the mapper's
+// association maps, are destroyed after it and still release paths then.
+static PathAtomPool& pathAtomPool()
+{
+    static auto* pool = new PathAtomPool;
+    return *pool;
+}
+
+PathAtomStats pathAtomStats()
+{
+    return pathAtomPool().stats();
+}
+
+PathAtom::Shared* PathAtom::intern(std::string_view path)
+{
+    if (path.empty())
+    {
+        return nullptr;
+    }
+
+    PathAtomPool& pool = pathAtomPool();
+    Shared* shared = pool.find(path);
+    if (shared != nullptr)
+    {
+        shared->refs++;
+        return shared;
+    }
+
+    shared = new Shared{1, std::string(path)};
+    pool.insert(shared);
+    return shared;
+}
+
+PathAtom PathAtom::lookup(std::string_view path)
+{
+    PathAtom found;
+    found.shared = pathAtomPool().find(path);
+    if (found.shared != nullptr)
+    {
+        found.shared->refs++;
+    }
+    return found;
+}
+
+const std::string& PathAtom::emptyPath()
+{
+    static const std::string empty;
+    return empty;
+}
+
+void PathAtom::release()
+{
+    if (shared != nullptr && --shared->refs == 0)
+    {
+        pathAtomPool().erase(shared);
+        delete shared;
+    }
+    shared = nullptr;
+}
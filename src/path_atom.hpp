@@ -0,0 +1,186 @@
+#pragma once
+
+#include <compare>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+class PathAtom;
+
+/** @brief A string type a path can be compared with without interning it */
+template <typename Path>
+concept PathText = std::convertible_to<const Path&, std::string_view> &&
+                   !std::same_as<Path, PathAtom>;
+
+/** @brief An object path that is stored once, however many places refer
+ *         to it.
+ *
+ * The association maps refer to the same few paths over and over: an
+ * association object's path is the key of its interface, of its entry
+ * under its owner and of its pending entry, and an endpoint shows up in
+ * the endpoints of every association to it.  A PathAtom is a reference
+ * counted handle to a path in a global pool, so all of those share one
+ * copy, and comparing two handles for equality is a pointer compare.
+ *
+ * It converts to and from strings implicitly, and orders like the path
+ * itself, so containers keyed by it can still be searched with a string.
+ *
+ * Whole paths are interned, rather than segments with a link to their
+ * parent.  Nearly every user needs the path as one string: replies copy
+ * it, and the maps keyed by it compare it with the string of a request.
+ * Stored as segments, each of those would have to put the path back
+ * together, which would make lookups slower still than the pointer hop
+ * whole paths already add.  Sharing segments would only save about
+ * another 10% of the heap on a large sensor tree, since most of a path's
+ * bytes are in segments that only it has, and the interface map already
+ * walks paths by segment in its own PathNode tree.
+ */
+class PathAtom
+{
+  public:
+    PathAtom() = default;
+
+    // Implicit, so a string can be passed wherever a path is stored
+    PathAtom(std::string_view path) : shared(intern(path)) {}
+    PathAtom(const std::string& path) : PathAtom(std::string_view(path)) {}
+    PathAtom(const char* path) : PathAtom(std::string_view(path)) {}
+
+    PathAtom(const PathAtom& other) : shared(other.shared)
+    {
+        if (shared != nullptr)
+        {
+            shared->refs++;
+        }
+    }
+
+    PathAtom(PathAtom&& other) noexcept :
+        shared(std::exchange(other.shared, nullptr))
+    {}
+
+    PathAtom& operator=(const PathAtom& other)
+    {
+        PathAtom(other).swap(*this);
+        return *this;
+    }
+
+    PathAtom& operator=(PathAtom&& other) noexcept
+    {
+        PathAtom(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~PathAtom()
+    {
+        release();
+    }
+
+    /** @brief Get the stored path without storing it if it isn't
+     *
+     * @param[in] path - The object path
+     *
+     * @return The path, or the empty path if it isn't stored
+     */
+    static PathAtom lookup(std::string_view path);
+
+    const std::string& str() const
+    {
+        return shared == nullptr ? emptyPath() : shared->path;
+    }
+
+    operator const std::string&() const
+    {
+        return str();
+    }
+
+    bool empty() const
+    {
+        return shared == nullptr;
+    }
+
+    void swap(PathAtom& other) noexcept
+    {
+        std::swap(shared, other.shared);
+    }
+
+    // Equal paths are always shared, so comparing them is cheap
+    friend bool operator==(const PathAtom& lhs, const PathAtom& rhs)
+    {
+        return lhs.shared == rhs.shared;
+    }
+
+    template <typename Path>
+        requires PathText<Path>
+    friend bool operator==(const PathAtom& lhs, const Path& rhs)
+    {
+        return std::string_view(lhs.str()) == std::string_view(rhs);
+    }
+
+    friend std::strong_ordering operator<=>(const PathAtom& lhs,
+                                            const PathAtom& rhs)
+    {
+        if (lhs.shared == rhs.shared)
+        {
+            return std::strong_ordering::equal;
+        }
+        return lhs.str() <=> rhs.str();
+    }
+
+    template <typename Path>
+        requires PathText<Path>
+    friend std::strong_ordering operator<=>(const PathAtom& lhs,
+                                            const Path& rhs)
+    {
+        return std::string_view(lhs.str()) <=> std::string_view(rhs);
+    }
+
+    friend std::ostream& operator<<(std::ostream& stream, const PathAtom& path)
+    {
+        return stream << path.str();
+    }
+
+  private:
+    friend class PathAtomPool;
+    friend struct std::hash<PathAtom>;
+
+    struct Shared
+    {
+        size_t refs;
+        std::string path;
+    };
+
+    static Shared* intern(std::string_view path);
+    static const std::string& emptyPath();
+    void release();
+
+    // Null for the empty path
+    Shared* shared = nullptr;
+};
+
+template <>
+struct std::hash<PathAtom>
+{
+    size_t operator()(const PathAtom& path) const
+    {
+        return std::hash<const void*>{}(path.shared);
+    }
+};
+
+/** @brief How much sharing of paths is going on */
+struct PathAtomStats
+{
+    // The number of distinct paths stored
+    size_t paths = 0;
+    // The number of handles that refer to them
+    size_t references = 0;
+    // The number of characters stored
+    size_t storedChars = 0;
+    // The number of characters there would be without sharing
+    size_t referencedChars = 0;
+};
+
+/** @brief Get the sharing stats of all paths */
+PathAtomStats pathAtomStats();
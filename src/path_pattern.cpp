@@ -0,0 +1,87 @@
+#include "path_pattern.hpp"
+
+// Match a segment against a glob, going back to the last '*' seen when
+// the rest doesn't match, so it takes one more character
+static bool globMatch(std::string_view glob, std::string_view text)
+{
+    size_t g = 0;
+    size_t t = 0;
+    size_t star = std::string_view::npos;
+    size_t mark = 0;
+    while (t < text.size())
+    {
+        if (g < glob.size() && (glob[g] == '?' || glob[g] == text[t]))
+        {
+            g++;
+            t++;
+        }
+        else if (g < glob.size() && glob[g] == '*')
+        {
+            star = g++;
+            mark = t;
+        }
+        else if (star != std::string_view::npos)
+        {
+            g = star + 1;
+            t = ++mark;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while (g < glob.size() && glob[g] == '*')
+    {
+        g++;
+    }
+    return g == glob.size();
+}
+
+bool PathPattern::Segment::matches(std::string_view segment) const
+{
+    if (literal())
+    {
+        return segment == glob;
+    }
+    return !segment.empty() && segment.starts_with(prefix()) &&
+           globMatch(std::string_view(glob).substr(prefixSize),
+                     segment.substr(prefixSize));
+}
+
+QueryResult<PathPattern> PathPattern::compile(std::string_view pattern)
+{
+    if (!pattern.starts_with('/'))
+    {
+        return std::unexpected(QueryError::invalidArgument);
+    }
+
+    PathPattern compiled;
+    if (pattern == "/")
+    {
+        // The path "/" is the single empty segment
+        compiled.parts.push_back({"", 0});
+        return compiled;
+    }
+    if (pattern.ends_with('/'))
+    {
+        pattern.remove_suffix(1);
+    }
+
+    pattern.remove_prefix(1);
+    for (size_t pos = 0, end = 0; end != std::string_view::npos; pos = end + 1)
+    {
+        end = pattern.find('/', pos);
+        std::string_view glob = pattern.substr(pos, end - pos);
+        if (glob.empty())
+        {
+            return std::unexpected(QueryError::invalidArgument);
+        }
+        size_t prefixSize = glob.find_first_of("*?");
+        if (prefixSize == std::string_view::npos)
+        {
+            prefixSize = glob.size();
+        }
+        compiled.parts.push_back({std::string(glob), prefixSize});
+    }
+    return compiled;
+}
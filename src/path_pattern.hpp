@@ -0,0 +1,69 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/** @brief An object path pattern with globs in its segments.
+ *
+ * A '*' in a segment matches any run of characters within that segment,
+ * and a '?' matches any one character, so a pattern only matches paths
+ * with as many segments as it has.  Neither matches the empty segment of
+ * the path "/".
+ *
+ * Each segment is compiled once, to the literal text up to its first glob
+ * character and the glob itself, so a path tree walk can look up a child
+ * directly when a segment is literal, and otherwise only visit the
+ * children that start with its literal prefix.
+ */
+class PathPattern
+{
+  public:
+    /** @brief One compiled segment of a pattern */
+    struct Segment
+    {
+        // The whole segment, as given
+        std::string glob;
+
+        // The length of the part before the first glob character
+        size_t prefixSize;
+
+        /** @brief The part of the segment before the first glob character */
+        std::string_view prefix() const
+        {
+            return std::string_view(glob).substr(0, prefixSize);
+        }
+
+        /** @brief True if the segment has no glob characters */
+        bool literal() const
+        {
+            return prefixSize == glob.size();
+        }
+
+        /** @brief Check if a path segment matches this one */
+        bool matches(std::string_view segment) const;
+    };
+
+    /** @brief Compile a pattern
+     *
+     * @param[in] pattern - An object path with globs in its segments.  A
+     *                      trailing '/' is ignored, except in "/".
+     *
+     * @return The pattern, or QueryError::invalidArgument if it isn't an
+     *         absolute path or has an empty segment
+     */
+    static QueryResult<PathPattern> compile(std::string_view pattern);
+
+    const std::vector<Segment>& segments() const
+    {
+        return parts;
+    }
+
+  private:
+    PathPattern() = default;
+
+    std::vector<Segment> parts;
+};
@@ -7,6 +7,7 @@
 #include <iostream>
 #include <string>
 #include <string_view>
+#include <vector>
 
 bool getWellKnown(
     const boost::container::flat_map<std::string, std::string>& owners,
@@ -56,60 +57,63 @@ void processNameChangeDelete(
             nameOwners.erase(it);
         }
     }
-    // Connection removed
-    InterfaceMapType::iterator pathIt = interfaceMap.begin();
-    while (pathIt != interfaceMap.end())
+    // Connection removed.  Only its own paths are visited, and it is taken
+    // off all of them at once afterwards.
+    const InterfaceMapType::PathSet* owned =
+        interfaceMap.findConnection(wellKnown);
+    if (owned == nullptr)
     {
+        return;
+    }
+    for (const PathNode* node : *owned)
+    {
+        const auto& [path, connections] = *node->entry;
+
         // If an associations interface is being removed,
         // also need to remove the corresponding associations
         // objects and properties.
-        auto ifaces = pathIt->second.find(wellKnown);
-        if (ifaces != pathIt->second.end())
+        const InterfaceIds* ifaces = findInterfaces(connections, wellKnown);
+        if (ifaces != nullptr)
         {
-            auto assoc = std::find(ifaces->second.begin(), ifaces->second.end(),
-                                   assocDefsInterface);
-            if (assoc != ifaces->second.end())
+            if (containsInterface(*ifaces, assocDefsInterface))
             {
-                removeAssociation(io, pathIt->first, wellKnown, server,
-                                  assocMaps);
+                removeAssociation(io, path, wellKnown, server, assocMaps);
             }
 
             // Instead of checking if every single path is the endpoint of an
             // association that needs to be moved to pending, only check when
             // we own this path as well, which would be because of an
             // association.
-            if ((pathIt->second.size() == 2) &&
-                (pathIt->second.find("xyz.openbmc_project.ObjectMapper") !=
-                 pathIt->second.end()))
+            if ((connections.size() == 2) &&
+                (findInterfaces(connections,
+                                "xyz.openbmc_project.ObjectMapper") != nullptr))
             {
                 // Remove the 2 association D-Bus paths and move the
                 // association to pending.
-                moveAssociationToPending(io, pathIt->first, assocMaps, server);
+                moveAssociationToPending(io, path, assocMaps, server);
             }
         }
-        pathIt->second.erase(wellKnown);
-        if (pathIt->second.empty())
-        {
-            // If the last connection to the object is gone,
-            // delete the top level object
-            pathIt = interfaceMap.erase(pathIt);
-            continue;
-        }
-        pathIt++;
     }
+    // If the last connection to an object is gone, the object is deleted
+    // too
+    interfaceMap.removeConnection(wellKnown);
 }
 
 void processInterfaceAdded(
     boost::asio::io_context& io, InterfaceMapType& interfaceMap,
-    const sdbusplus::message::object_path& objPath,
+    MissCache& missCache, const sdbusplus::message::object_path& objPath,
     const InterfacesAdded& intfAdded, const std::string& wellKnown,
     AssociationMaps& assocMaps, sdbusplus::asio::object_server& server)
 {
-    auto& ifaceList = interfaceMap[objPath.str];
+    auto [pathIt, added] = interfaceMap.emplace(objPath.str);
+    if (added)
+    {
+        missCache.erase(objPath.str);
+    }
 
     for (const auto& interfacePair : intfAdded)
     {
-        ifaceList[wellKnown].emplace(interfacePair.first);
+        interfaceMap.addInterface(pathIt, wellKnown, interfacePair.first);
 
         if (interfacePair.first == assocDefsInterface)
         {
@@ -147,9 +151,6 @@ void processInterfaceAdded(
     //
     // This is all needed so that mapper operations can be done
     // on the new parent paths.
-    using iface_map_iterator = InterfaceMapType::iterator;
-    using name_map_iterator = ConnectionNames::iterator;
-
     std::string parent = objPath.str;
     auto pos = parent.find_last_of('/');
 
@@ -157,13 +158,13 @@ void processInterfaceAdded(
     {
         parent = parent.substr(0, pos);
 
-        std::pair<iface_map_iterator, bool> parentEntry =
-            interfaceMap.emplace(parent, ConnectionNames{});
-
-        std::pair<name_map_iterator, bool> ifaceEntry =
-            parentEntry.first->second.emplace(wellKnown, InterfaceNames{});
+        auto parentEntry = interfaceMap.emplace(parent);
+        if (parentEntry.second)
+        {
+            missCache.erase(parent);
+        }
 
-        if (!ifaceEntry.second)
+        if (!interfaceMap.addConnection(parentEntry.first, wellKnown))
         {
             // Entry was already there for this name so done.
             break;
@@ -175,3 +176,48 @@ void processInterfaceAdded(
     // The new interface might have an association pending
     checkIfPendingAssociation(io, objPath.str, interfaceMap, assocMaps, server);
 }
+
+void removeUnneededParents(const std::string& objectPath,
+                           const std::string& owner,
+                           InterfaceMapType& interfaceMap)
+{
+    auto parent = objectPath;
+
+    while (true)
+    {
+        auto pos = parent.find_last_of('/');
+        if ((pos == std::string::npos) || (pos == 0))
+        {
+            break;
+        }
+        parent = parent.substr(0, pos);
+
+        auto parentIt = interfaceMap.find(parent);
+        if (parentIt == interfaceMap.end())
+        {
+            break;
+        }
+
+        const InterfaceIds* ifaces = findInterfaces(parentIt->second, owner);
+        if (ifaces == nullptr)
+        {
+            break;
+        }
+
+        if (!ifaces->onlyStandard())
+        {
+            break;
+        }
+
+        // Remove this parent if there isn't a remaining child on this owner
+        if (interfaceMap.hasConnectionBelow(parentIt, owner))
+        {
+            break;
+        }
+        interfaceMap.removeConnection(parentIt, owner);
+        if (parentIt->second.empty())
+        {
+            interfaceMap.erase(parentIt);
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
-#include "types.hpp"
+#include "interface_map.hpp"
+#include "miss_cache.hpp"
 
 #include <boost/container/flat_map.hpp>
 
@@ -71,6 +72,8 @@ void processNameChangeDelete(
  *
  * @param[in] io                  - io context
  * @param[in,out] interfaceMap    - Global map of interfaces
+ * @param[in,out] missCache       - The paths GetObject missed, which
+ *                                  forgets the paths that are added
  * @param[in]     objPath         - New path to process
  * @param[in]     interfacesAdded - New interfaces to process
  * @param[in]     wellKnown       - Well known name that has new owner
@@ -80,6 +83,23 @@ void processNameChangeDelete(
  */
 void processInterfaceAdded(
     boost::asio::io_context& io, InterfaceMapType& interfaceMap,
-    const sdbusplus::message::object_path& objPath,
+    MissCache& missCache, const sdbusplus::message::object_path& objPath,
     const InterfacesAdded& intfAdded, const std::string& wellKnown,
     AssociationMaps& assocMaps, sdbusplus::asio::object_server& server);
+
+/** @brief Remove the parents of a path that an owner no longer needs
+ *
+ * Parents are removed from the owner, starting at the closest one, while
+ * they:
+ * 1) Only have the 3 default interfaces on them
+ *    - Means D-Bus created these, not application code,
+ *      with the Properties, Introspectable, and Peer ifaces
+ * 2) Have no other child for this owner
+ *
+ * @param[in]     objectPath   - The path the owner removed interfaces from
+ * @param[in]     owner        - The owner of the path
+ * @param[in,out] interfaceMap - Global map of interfaces
+ */
+void removeUnneededParents(const std::string& objectPath,
+                           const std::string& owner,
+                           InterfaceMapType& interfaceMap);
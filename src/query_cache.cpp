@@ -0,0 +1,35 @@
+#include "query_cache.hpp"
+
+#include <boost/container_hash/hash.hpp>
+
+#include <algorithm>
+#include <limits>
+
+QueryKey makeQueryKey(std::string_view method, const std::string& reqPath,
+                      int32_t depth, const std::vector<std::string>& interfaces)
+{
+    QueryKey key{std::string(method), reqPath, depth, interfaces};
+    if (key.path.ends_with("/"))
+    {
+        key.path.pop_back();
+    }
+    if (key.depth <= 0)
+    {
+        key.depth = std::numeric_limits<int32_t>::max();
+    }
+    std::sort(key.interfaces.begin(), key.interfaces.end());
+    key.interfaces.erase(
+        std::unique(key.interfaces.begin(), key.interfaces.end()),
+        key.interfaces.end());
+    return key;
+}
+
+size_t QueryKeyHash::operator()(const QueryKey* key) const
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, key->method);
+    boost::hash_combine(seed, key->path);
+    boost::hash_combine(seed, key->depth);
+    boost::hash_range(seed, key->interfaces.begin(), key->interfaces.end());
+    return seed;
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include "interface_map.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+constexpr size_t queryCacheEntries = 64;
+
+// The most bytes of replies the reply cache keeps.  Replies larger than a
+// quarter of it aren't cached, so one of them can't push out most others.
+constexpr size_t queryCacheBytes = 4 * 1024 * 1024;
+
+/** @brief A subtree query, as a cache key */
+struct QueryKey
+{
+    std::string method;
+    std::string path;
+    int32_t depth;
+    std::vector<std::string> interfaces;
+
+    bool operator==(const QueryKey&) const = default;
+};
+
+/** @brief Make the cache key of a subtree query
+ *
+ * Requests that always give the same result share a key, so a trailing
+ * '/', any depth below 1 and the order of the interfaces don't matter.
+ *
+ * @param[in] method     - The D-Bus method name
+ * @param[in] reqPath    - The requested path
+ * @param[in] depth      - The requested depth
+ * @param[in] interfaces - The requested interfaces
+ *
+ * @return The key
+ */
+QueryKey makeQueryKey(std::string_view method, const std::string& reqPath,
+                      int32_t depth,
+                      const std::vector<std::string>& interfaces);
+
+struct QueryKeyHash
+{
+    size_t operator()(const QueryKey* key) const;
+};
+
+struct QueryCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    // Values that were too large to keep
+    uint64_t uncached = 0;
+};
+
+/** @brief Counts every value as taking no bytes, so only the number of
+ *         entries bounds the cache
+ */
+struct NoValueSize
+{
+    template <typename Value>
+    size_t operator()(const Value& /*value*/) const
+    {
+        return 0;
+    }
+};
+
+/** @brief A bounded LRU cache of what subtree queries produced.
+ *
+ * Each value is stored with the generation of the path tree node of the
+ * requested path.  Any change to the interface map at or below that node
+ * gives it a new generation, so a value is only reused while nothing it
+ * was built from has changed.  Changes elsewhere in the tree don't affect
+ * it.
+ *
+ * The cache is bounded by the number of entries and by the total size of
+ * the values, as Size reports it.  A value larger than maxValueBytes is
+ * returned but not kept.
+ *
+ * @tparam Value - What is kept per query
+ * @tparam Size  - Gets the size of a value in bytes
+ */
+template <typename Value, typename Size = NoValueSize>
+class QueryCache
+{
+  public:
+    /** @brief Constructor
+     *
+     * @param[in] maxEntries    - The number of values to keep
+     * @param[in] maxBytes      - The total size of the values to keep
+     * @param[in] maxValueBytes - The size of the largest value to keep
+     */
+    explicit QueryCache(
+        size_t maxEntries,
+        size_t maxBytes = std::numeric_limits<size_t>::max(),
+        size_t maxValueBytes = std::numeric_limits<size_t>::max()) :
+        capacity(maxEntries), byteCapacity(maxBytes),
+        valueCapacity(maxValueBytes)
+    {}
+
+    /** @brief Get the value of a query, making it if there is none
+     *
+     * @param[in] key          - The query
+     * @param[in] interfaceMap - The map the query reads
+     * @param[in] make         - Makes the value on a miss, or returns an
+     *                           error if the requested path doesn't exist.
+     *                           Errors aren't cached.
+     *
+     * @return The cached or new value, or the error
+     */
+    template <typename Make>
+    QueryResult<Value> get(QueryKey&& key, const InterfaceMapType& interfaceMap,
+                           Make&& make)
+    {
+        const PathNode* node = interfaceMap.findNode(key.path);
+        auto found = index.find(&key);
+        if (found != index.end())
+        {
+            auto entry = found->second;
+            if (node != nullptr && node->generation == entry->generation)
+            {
+                counters.hits++;
+                entries.splice(entries.begin(), entries, entry);
+                return entry->value;
+            }
+
+            // Something below the path changed since, so it is no use
+            index.erase(found);
+            bytes -= entry->bytes;
+            entries.erase(entry);
+        }
+        counters.misses++;
+
+        // Only fails if the path doesn't exist, so otherwise there is a node
+        QueryResult<Value> value = make();
+        if (!value)
+        {
+            return value;
+        }
+        size_t newBytes = Size()(*value);
+        if (newBytes > valueCapacity || newBytes > byteCapacity)
+        {
+            counters.uncached++;
+            return value;
+        }
+        entries.emplace_front(std::move(key), node->generation, newBytes,
+                              *value);
+        index.emplace(&entries.front().key, entries.begin());
+        bytes += newBytes;
+
+        while (entries.size() > capacity || bytes > byteCapacity)
+        {
+            index.erase(&entries.back().key);
+            bytes -= entries.back().bytes;
+            entries.pop_back();
+            counters.evictions++;
+        }
+        return value;
+    }
+
+    const QueryCacheStats& stats() const
+    {
+        return counters;
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    /** @brief The total size of the cached values */
+    size_t valueBytes() const
+    {
+        return bytes;
+    }
+
+  private:
+    struct KeyEqual
+    {
+        bool operator()(const QueryKey* lhs, const QueryKey* rhs) const
+        {
+            return *lhs == *rhs;
+        }
+    };
+
+    struct Entry
+    {
+        QueryKey key;
+        uint64_t generation;
+        size_t bytes;
+        Value value;
+    };
+
+    size_t capacity;
+    size_t byteCapacity;
+    size_t valueCapacity;
+    size_t bytes = 0;
+
+    // Most recently used first
+    std::list<Entry> entries;
+
+    // Keys point into the entry they map to
+    std::unordered_map<const QueryKey*, typename std::list<Entry>::iterator,
+                       QueryKeyHash, KeyEqual>
+        index;
+
+    QueryCacheStats counters;
+};
@@ -0,0 +1,90 @@
+#include "reply_cache.hpp"
+
+#include "handler.hpp"
+#include "marshalled_size.hpp"
+
+#include <sdbusplus/exception.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+ReplyCache::ReplyCache(const InterfaceMapType& map, size_t maxEntries,
+                       size_t maxBytes) :
+    interfaceMap(map), cache(maxEntries, maxBytes, maxBytes / 4)
+{}
+
+sdbusplus::message_t ReplyCache::copyReply(sdbusplus::message_t& call,
+                                           sdbusplus::message_t& cached)
+{
+    sdbusplus::message_t reply = call.new_method_return();
+    int r = sd_bus_message_rewind(cached.get(), true);
+    if (r >= 0)
+    {
+        r = sd_bus_message_copy(reply.get(), cached.get(), true);
+    }
+    if (r < 0)
+    {
+        throw sdbusplus::exception::SdBusError(-r, "sd_bus_message_copy");
+    }
+    return reply;
+}
+
+template <typename Query>
+QueryResult<void> ReplyCache::answer(sdbusplus::message_t& call,
+                                     QueryKey&& key, Query&& query)
+{
+    // Only a reply that was sent is sealed and can be copied from
+    bool replied = false;
+    QueryResult<CachedReply> cached = cache.get(
+        std::move(key), interfaceMap, [&]() -> QueryResult<CachedReply> {
+            auto result = query();
+            if (!result)
+            {
+                return std::unexpected(result.error());
+            }
+            sdbusplus::message_t reply = call.new_method_return();
+            reply.append(*result);
+            reply.method_return();
+            replied = true;
+            return CachedReply{std::move(reply), marshalledSize(*result)};
+        });
+    if (!cached)
+    {
+        return std::unexpected(cached.error());
+    }
+    if (!replied)
+    {
+        copyReply(call, cached->message).method_return();
+    }
+    return {};
+}
+
+QueryResult<void> ReplyCache::getSubTree(sdbusplus::message_t& call)
+{
+    std::string reqPath;
+    int32_t depth = 0;
+    std::vector<std::string> interfaces;
+    call.read(reqPath, depth, interfaces);
+
+    return answer(call, makeQueryKey("GetSubTree", reqPath, depth, interfaces),
+                  [&]() {
+                      return tryGetSubTree(interfaceMap, reqPath, depth,
+                                           interfaces);
+                  });
+}
+
+QueryResult<void> ReplyCache::getSubTreePaths(sdbusplus::message_t& call)
+{
+    std::string reqPath;
+    int32_t depth = 0;
+    std::vector<std::string> interfaces;
+    call.read(reqPath, depth, interfaces);
+
+    return answer(call,
+                  makeQueryKey("GetSubTreePaths", reqPath, depth, interfaces),
+                  [&]() {
+                      return tryGetSubTreePaths(interfaceMap, reqPath, depth,
+                                                interfaces);
+                  });
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "interface_map.hpp"
+#include "query_cache.hpp"
+
+#include <sdbusplus/message.hpp>
+
+#include <cstddef>
+
+/** @brief Answers GetSubTree and GetSubTreePaths with cached reply bodies.
+ *
+ * Building the result vector and marshalling it costs more than the
+ * lookup for big replies, so the reply message sent for a query is kept.
+ * A repeated query copies its body into the new reply without decoding
+ * it, until something below the requested path changes.  The cache is
+ * bounded by the size of the reply bodies as well as their number, since
+ * a single GetSubTree reply of a large system can take megabytes.
+ */
+class ReplyCache
+{
+  public:
+    /** @brief Constructor
+     *
+     * @param[in] map        - The map the methods read
+     * @param[in] maxEntries - The number of replies to keep
+     * @param[in] maxBytes   - The total body size of the replies to keep.
+     *                         Replies larger than a quarter of it aren't
+     *                         kept.
+     */
+    ReplyCache(const InterfaceMapType& map, size_t maxEntries,
+               size_t maxBytes);
+
+    /** @brief Reply to a GetSubTree call
+     *
+     * @param[in] call - The method call
+     *
+     * @return Nothing if the reply was sent, or the error to reply with
+     */
+    QueryResult<void> getSubTree(sdbusplus::message_t& call);
+
+    /** @brief Reply to a GetSubTreePaths call */
+    QueryResult<void> getSubTreePaths(sdbusplus::message_t& call);
+
+    /** @brief Make a reply to a call with the body of another reply
+     *
+     * @param[in] call   - The method call
+     * @param[in] cached - A reply that has been sent
+     *
+     * @return The unsent reply
+     */
+    static sdbusplus::message_t copyReply(sdbusplus::message_t& call,
+                                          sdbusplus::message_t& cached);
+
+    const QueryCacheStats& stats() const
+    {
+        return cache.stats();
+    }
+
+  private:
+    /** @brief A sent reply and the size of its body */
+    struct CachedReply
+    {
+        sdbusplus::message_t message;
+        size_t bytes;
+    };
+
+    struct CachedReplySize
+    {
+        size_t operator()(const CachedReply& reply) const
+        {
+            return reply.bytes;
+        }
+    };
+
+    template <typename Query>
+    QueryResult<void> answer(sdbusplus::message_t& call, QueryKey&& key,
+                             Query&& query);
+
+    const InterfaceMapType& interfaceMap;
+    QueryCache<CachedReply, CachedReplySize> cache;
+};
@@ -474,6 +474,34 @@ TEST_F(TestAssociations, checkIfPending)
     EXPECT_EQ(assocMaps.ifaces.size(), 2);
 }
 
+// Test moving the pending associations of a batch of added paths
+TEST_F(TestAssociations, checkIfPendingBatch)
+{
+    AssociationMaps assocMaps;
+    InterfaceMapType interfaceMap = {
+        {defaultSourcePath, {{defaultDbusSvc, {"a"}}}},
+        {defaultEndpoint, {{defaultDbusSvc, {"b"}}}}};
+
+    addPendingAssociation(defaultSourcePath, "inventory_cip", defaultEndpoint,
+                          "error_cip", defaultDbusSvc, assocMaps);
+    addPendingAssociation("/not/added", "inventory_cip", defaultEndpoint,
+                          "error_cip", defaultDbusSvc, assocMaps);
+    EXPECT_EQ(assocMaps.pending.size(), 2);
+
+    // More pending associations than paths in the batch
+    checkIfPendingAssociations(io, {"/new/path"}, interfaceMap, assocMaps,
+                               *server);
+    EXPECT_EQ(assocMaps.pending.size(), 2);
+
+    // And fewer
+    checkIfPendingAssociations(io, {"/a", "/b", defaultSourcePath},
+                               interfaceMap, assocMaps, *server);
+    ASSERT_EQ(assocMaps.pending.size(), 1);
+    EXPECT_EQ(assocMaps.pending.begin()->first, "/not/added");
+    EXPECT_EQ(assocMaps.owners.size(), 1);
+    EXPECT_EQ(assocMaps.ifaces.size(), 2);
+}
+
 TEST_F(TestAssociations, findAssociations)
 {
     std::vector<std::tuple<std::string, Association>> associationData;
@@ -0,0 +1,143 @@
+#include "src/bulk_load.hpp"
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+
+static std::vector<std::string> paths(const InterfaceMapType& interfaceMap)
+{
+    std::vector<std::string> result;
+    for (const auto& [path, _] : interfaceMap)
+    {
+        result.emplace_back(path);
+    }
+    return result;
+}
+
+// Verify staged paths only show up on commit, and then in path order with
+// their indexes up to date
+TEST(BulkLoad, CommitInPathOrder)
+{
+    InterfaceMapType interfaceMap = {{"/a", {{"other", {"iface0"}}}}};
+    BulkLoad bulkLoad("conn");
+    bulkLoad.add("/", {});
+    bulkLoad.add("/c/z", {"iface1", "iface0"});
+    bulkLoad.add("/c", {"iface0"});
+    bulkLoad.add("/a", {"iface1"});
+    bulkLoad.add("/c/y", {"iface1", "iface1"});
+    EXPECT_EQ(bulkLoad.size(), 5);
+    EXPECT_THAT(paths(interfaceMap), ElementsAre("/a"));
+
+    EXPECT_THAT(bulkLoad.commit(interfaceMap),
+                ElementsAre("/c", "/c/y", "/c/z"));
+    EXPECT_EQ(bulkLoad.size(), 0);
+
+    // A path staged without interfaces would never be erased again, so it
+    // isn't added
+    EXPECT_THAT(paths(interfaceMap), ElementsAre("/a", "/c", "/c/y", "/c/z"));
+    EXPECT_THAT(
+        toConnectionNames(interfaceMap.find("/a")->second),
+        ElementsAre(Pair("conn", ElementsAre("iface1")),
+                    Pair("other", ElementsAre("iface0"))));
+    EXPECT_THAT(toConnectionNames(interfaceMap.find("/c/z")->second),
+                ElementsAre(Pair("conn", ElementsAre("iface0", "iface1"))));
+    EXPECT_THAT(toConnectionNames(interfaceMap.find("/c/y")->second),
+                ElementsAre(Pair("conn", ElementsAre("iface1"))));
+
+    ASSERT_NE(interfaceMap.findInterface("iface1"), nullptr);
+    EXPECT_EQ(interfaceMap.findInterface("iface1")->size(), 3);
+    ASSERT_NE(interfaceMap.findConnection("conn"), nullptr);
+    EXPECT_EQ(interfaceMap.findConnection("conn")->size(), 4);
+    EXPECT_TRUE(
+        interfaceMap.hasConnectionBelow(interfaceMap.find("/c"), "conn"));
+    EXPECT_EQ(interfaceMap.findNode("/c")->children.size(), 2);
+}
+
+// Verify interfaces the service removes before its scan is committed are
+// not added, and interfaces it adds to the map directly are kept
+TEST(BulkLoad, SignalsWhileStaged)
+{
+    InterfaceMapType interfaceMap;
+    BulkLoad bulkLoad("conn");
+    bulkLoad.add("/a", {"iface0", "iface1"});
+    bulkLoad.add("/b", {"iface0"});
+
+    EXPECT_TRUE(bulkLoad.remove("/a", {"iface1", "unknown"}));
+    EXPECT_TRUE(bulkLoad.remove("/b", {"iface0"}));
+    EXPECT_FALSE(bulkLoad.remove("/b", {"iface0"}));
+    EXPECT_FALSE(bulkLoad.remove("/c", {"iface0"}));
+
+    // As if from InterfacesAdded while the scan was running
+    auto [a, _] = interfaceMap.emplace("/a");
+    interfaceMap.addInterface(a, "conn", "iface2");
+
+    // The path was introspected again later on
+    bulkLoad.add("/b", {"iface1"});
+
+    EXPECT_THAT(bulkLoad.commit(interfaceMap), ElementsAre("/b"));
+    EXPECT_THAT(
+        toConnectionNames(interfaceMap.find("/a")->second),
+        ElementsAre(Pair("conn", ElementsAre("iface0", "iface2"))));
+    EXPECT_THAT(toConnectionNames(interfaceMap.find("/b")->second),
+                ElementsAre(Pair("conn", ElementsAre("iface1"))));
+}
+
+// Verify nothing is added for a service that left the bus during its scan
+TEST(BulkLoad, Cancel)
+{
+    InterfaceMapType interfaceMap;
+    BulkLoad bulkLoad("conn");
+    bulkLoad.add("/a", {"iface0"});
+    bulkLoad.cancel();
+    bulkLoad.add("/b", {"iface0"});
+    EXPECT_FALSE(bulkLoad.remove("/a", {"iface0"}));
+
+    EXPECT_THAT(bulkLoad.commit(interfaceMap), IsEmpty());
+    EXPECT_TRUE(interfaceMap.empty());
+}
+
+// Verify a scan can go on staging after a batch of it was committed, and
+// a path in both batches gets the interfaces of both
+TEST(BulkLoad, CommitInBatches)
+{
+    InterfaceMapType interfaceMap;
+    BulkLoad bulkLoad("conn");
+    bulkLoad.add("/b", {"iface0"});
+    bulkLoad.add("/a", {"iface0"});
+    EXPECT_THAT(bulkLoad.commit(interfaceMap), ElementsAre("/a", "/b"));
+
+    bulkLoad.add("/c", {"iface0"});
+    bulkLoad.add("/a", {"iface1"});
+    EXPECT_EQ(bulkLoad.size(), 2);
+    EXPECT_THAT(bulkLoad.commit(interfaceMap), ElementsAre("/c"));
+    EXPECT_THAT(paths(interfaceMap), ElementsAre("/a", "/b", "/c"));
+    EXPECT_THAT(toConnectionNames(interfaceMap.find("/a")->second),
+                ElementsAre(Pair("conn", ElementsAre("iface0", "iface1"))));
+}
+
+// Verify a path that was already in the map isn't returned as added, so
+// it isn't treated as new, but still gets the staged interfaces
+TEST(BulkLoad, CommitReturnsOnlyNewPaths)
+{
+    InterfaceMapType interfaceMap = {{"/a", {{"other", {"iface0"}}}},
+                                     {"/c", {{"conn", {"iface0"}}}}};
+    BulkLoad bulkLoad("conn");
+    bulkLoad.add("/a", {"iface1"});
+    bulkLoad.add("/b", {"iface1"});
+    bulkLoad.add("/c", {"iface1"});
+
+    EXPECT_THAT(bulkLoad.commit(interfaceMap), ElementsAre("/b"));
+    EXPECT_THAT(paths(interfaceMap), ElementsAre("/a", "/b", "/c"));
+    EXPECT_THAT(
+        toConnectionNames(interfaceMap.find("/a")->second),
+        ElementsAre(Pair("conn", ElementsAre("iface1")),
+                    Pair("other", ElementsAre("iface0"))));
+    EXPECT_THAT(toConnectionNames(interfaceMap.find("/c")->second),
+                ElementsAre(Pair("conn", ElementsAre("iface0", "iface1"))));
+}
@@ -0,0 +1,180 @@
+#include "src/direct_methods.hpp"
+#include "src/handler.hpp"
+
+#include <systemd/sd-bus.h>
+
+#include <sdbusplus/bus.hpp>
+#include <sdbusplus/exception.hpp>
+#include <sdbusplus/message/types.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// The signature sdbusplus marshals values of the types with
+template <typename... Types>
+static std::string signature()
+{
+    return std::apply([](auto... id) { return std::string({id...}); },
+                      sdbusplus::message::types::type_id<Types...>())
+        .c_str();
+}
+
+// The signature of the arguments a method reads into
+template <typename... Args>
+static std::string argumentSignature(const Args&...)
+{
+    return signature<Args...>();
+}
+
+// The signature of what a query replies with
+template <typename T>
+static std::string replySignature(const QueryResult<T>&)
+{
+    return signature<T>();
+}
+
+static const sdbusplus::vtable_t* findMethod(std::string_view name)
+{
+    for (const sdbusplus::vtable_t* entry = DirectMethods::vtable;
+         entry->type != _SD_BUS_VTABLE_END; entry++)
+    {
+        if (entry->type == _SD_BUS_VTABLE_METHOD &&
+            name == entry->x.method.member)
+        {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+// Verify the signatures in the vtable are those of the arguments the
+// methods read and the results they append to the reply
+TEST(DirectMethods, SignaturesMatchTypes)
+{
+    InterfaceMapType interfaceMap;
+    AssociationMaps associationMaps;
+    std::string path;
+    int32_t depth = 0;
+    std::vector<std::string> interfaces;
+    std::string id;
+    std::string association;
+    std::vector<std::string> endpointInterfaces;
+
+    struct Method
+    {
+        const char* name;
+        std::string signature;
+        std::string result;
+    };
+    const std::vector<Method> methods = {
+        {"GetObject", argumentSignature(path, interfaces),
+         replySignature(tryGetObject(interfaceMap, path, interfaces))},
+        {"GetAncestors", argumentSignature(path, interfaces),
+         replySignature(tryGetAncestors(interfaceMap, path, interfaces))},
+        {"GetSubTree", argumentSignature(path, depth, interfaces),
+         replySignature(tryGetSubTree(interfaceMap, path, depth, interfaces))},
+        {"GetSubTreePaths", argumentSignature(path, depth, interfaces),
+         replySignature(
+             tryGetSubTreePaths(interfaceMap, path, depth, interfaces))},
+        {"GetAssociatedSubTreeById",
+         argumentSignature(id, path, interfaces, association,
+                           endpointInterfaces),
+         replySignature(tryGetAssociatedSubTreeById(
+             interfaceMap, associationMaps, id, path, interfaces, association,
+             endpointInterfaces))},
+        {"GetAssociatedSubTreePathsById",
+         argumentSignature(id, path, interfaces, association,
+                           endpointInterfaces),
+         replySignature(tryGetAssociatedSubTreePathsById(
+             interfaceMap, associationMaps, id, path, interfaces, association,
+             endpointInterfaces))},
+    };
+
+    for (const Method& method : methods)
+    {
+        const sdbusplus::vtable_t* entry = findMethod(method.name);
+        ASSERT_NE(entry, nullptr) << method.name;
+        EXPECT_EQ(entry->x.method.signature, method.signature) << method.name;
+        EXPECT_EQ(entry->x.method.result, method.result) << method.name;
+    }
+}
+
+class TestDirectMethods : public testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        // Method calls can only be made on a bus connection
+        try
+        {
+            bus.emplace(sdbusplus::bus::new_default());
+        }
+        catch (const sdbusplus::exception_t&)
+        {
+            GTEST_SKIP() << "No D-Bus connection to make calls on";
+        }
+    }
+
+    void TearDown() override
+    {
+        sd_bus_error_free(&error);
+    }
+
+    // Call a method through its vtable entry, as sd-bus does
+    template <typename... Args>
+    int call(const char* method, const Args&... args)
+    {
+        sdbusplus::message_t message = bus->new_method_call(
+            "xyz.openbmc_project.ObjectMapper",
+            "/xyz/openbmc_project/object_mapper",
+            "xyz.openbmc_project.ObjectMapper", method);
+        message.append(args...);
+        EXPECT_GE(sd_bus_message_seal(message.get(), 1, 0), 0);
+        EXPECT_GE(sd_bus_message_rewind(message.get(), 1), 0);
+
+        const sdbusplus::vtable_t* entry = findMethod(method);
+        EXPECT_NE(entry, nullptr);
+        return entry->x.method.handler(message.get(), &methods, &error);
+    }
+
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"svc", {"iface0"}}}},
+    };
+    AssociationMaps associationMaps;
+    ReplyCache replyCache{interfaceMap, 16, 1024 * 1024};
+    MissCache missCache{16};
+    DirectMethods methods{interfaceMap, associationMaps, replyCache,
+                          missCache};
+    std::optional<sdbusplus::bus_t> bus;
+    sd_bus_error error{};
+};
+
+// Verify a query error is replied with its D-Bus error name, and a missed
+// GetObject path is remembered
+TEST_F(TestDirectMethods, QueryErrorIsErrorReply)
+{
+    EXPECT_LT(call("GetObject", std::string("/b"), std::vector<std::string>()),
+              0);
+    EXPECT_STREQ(error.name, errorName(QueryError::resourceNotFound));
+    EXPECT_TRUE(missCache.contains("/b"));
+
+    sd_bus_error_free(&error);
+    EXPECT_LT(call("GetSubTree", std::string("/b"), int32_t(0),
+                   std::vector<std::string>()),
+              0);
+    EXPECT_STREQ(error.name, errorName(QueryError::resourceNotFound));
+}
+
+// Verify a call whose arguments can't be read gets an error reply instead
+// of the exception escaping to sd-bus
+TEST_F(TestDirectMethods, ExceptionIsErrorReply)
+{
+    EXPECT_LT(call("GetObject", int32_t(1)), 0);
+    EXPECT_TRUE(sd_bus_error_is_set(&error));
+}
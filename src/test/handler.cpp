@@ -54,6 +54,7 @@ class TestHandler : public testing::Test
                             "/test/object_path_0/child",
                             "/test/object_path_0/child/grandchild",
                         },
+                        EndpointLookup(),
                     },
                 },
                 {
@@ -63,6 +64,7 @@ class TestHandler : public testing::Test
                         {
                             "/test/object_path_0/child/grandchild",
                         },
+                        EndpointLookup(),
                     },
                 },
                 {
@@ -72,6 +74,7 @@ class TestHandler : public testing::Test
                         {
                             "/test/object_path_0/child",
                         },
+                        EndpointLookup(),
                     },
                 },
                 {
@@ -82,6 +85,7 @@ class TestHandler : public testing::Test
                             "/test/object_path_0/child1",
                             "/test/object_path_0/child1/grandchild",
                         },
+                        EndpointLookup(),
                     },
                 },
             },
@@ -110,7 +114,7 @@ TEST_F(TestHandler, AddObjectMapResult)
     auto entry = std::find_if(
         interfaceMaps.begin(), interfaceMaps.end(),
         [](const auto& i) { return "test_object_path" == i.first; });
-    ASSERT_NE(entry, interfaceMap.end());
+    ASSERT_NE(entry, interfaceMaps.end());
     for (const auto& [_, interfaces] : entry->second)
     {
         ASSERT_THAT(interfaces,
@@ -192,6 +196,35 @@ TEST_F(TestHandler, getObjectBad)
         sdbusplus::xyz::openbmc_project::Common::Error::ResourceNotFound);
 }
 
+TEST_F(TestHandler, tryGetMisses)
+{
+    std::vector<std::string> interfaces = {"bad_interface"};
+    auto object = tryGetObject(interfaceMap, "/test/object_path_0", interfaces);
+    ASSERT_FALSE(object);
+    EXPECT_EQ(object.error(), QueryError::resourceNotFound);
+
+    interfaces.clear();
+    auto ancestors = tryGetAncestors(interfaceMap, "/invalid_path", interfaces);
+    ASSERT_FALSE(ancestors);
+    EXPECT_EQ(ancestors.error(), QueryError::resourceNotFound);
+
+    auto subtree = tryGetSubTree(interfaceMap, "/invalid_path", 0, interfaces);
+    ASSERT_FALSE(subtree);
+    EXPECT_EQ(subtree.error(), QueryError::resourceNotFound);
+
+    std::vector<std::string> endpointInterfaces;
+    auto paths = tryGetAssociatedSubTreePathsById(
+        interfaceMap, associationMap, "childx", "/test/object_path_0",
+        interfaces, "descendent", endpointInterfaces);
+    ASSERT_FALSE(paths);
+    EXPECT_EQ(paths.error(), QueryError::resourceNotFound);
+
+    EXPECT_STREQ(
+        errorName(QueryError::resourceNotFound),
+        sdbusplus::xyz::openbmc_project::Common::Error::ResourceNotFound::
+            errName);
+}
+
 TEST_F(TestHandler, getObjectGood)
 {
     std::string path = "/test/object_path_0";
@@ -209,6 +242,31 @@ TEST_F(TestHandler, getObjectGood)
     ASSERT_THAT(object->second, ElementsAre("test_interface_1"));
 }
 
+// Verify only paths that aren't in the map are remembered as misses, and
+// a remembered miss isn't looked up again
+TEST_F(TestHandler, tryGetObjectMissCache)
+{
+    MissCache missCache(16);
+    std::vector<std::string> interfaces = {"bad_interface"};
+    EXPECT_EQ(tryGetObject(interfaceMap, missCache, "/test/object_path_0",
+                           interfaces),
+              QueryResult<ConnectionNames>(
+                  std::unexpected(QueryError::resourceNotFound)));
+    EXPECT_EQ(missCache.size(), 0);
+
+    interfaces.clear();
+    EXPECT_FALSE(
+        tryGetObject(interfaceMap, missCache, "/invalid_path", interfaces));
+    EXPECT_EQ(missCache.size(), 1);
+
+    EXPECT_FALSE(tryGetObject(interfaceMap, missCache, "/invalid_path",
+                              interfaces));
+    EXPECT_EQ(missCache.stats().hits, 1);
+
+    EXPECT_TRUE(tryGetObject(interfaceMap, missCache, "/test/object_path_0",
+                             interfaces));
+}
+
 TEST_F(TestHandler, getSubTreeBad)
 {
     std::string path = "/test/object_path_0";
@@ -312,6 +370,267 @@ TEST_F(TestHandler, getSubTreePathsGood)
                 ElementsAre("/test/object_path_0/child/grandchild/dog"));
 }
 
+TEST_F(TestHandler, getObjectsByService)
+{
+    interfaceMap.addInterface(interfaceMap.emplace("/test/object_path_1").first,
+                              "test_object_connection_1", "test_interface_6");
+
+    std::vector<std::string> interfaces;
+    ServiceObjects objects = getObjectsByService(
+        interfaceMap, "test_object_connection_1", interfaces);
+    ASSERT_EQ(objects.size(), 2U);
+    EXPECT_EQ(objects[0].first, "/test/object_path_0/child");
+    EXPECT_THAT(objects[0].second, ElementsAre("test_interface_1"));
+    EXPECT_EQ(objects[1].first, "/test/object_path_1");
+    EXPECT_THAT(objects[1].second, ElementsAre("test_interface_6"));
+
+    interfaces = {"test_interface_6"};
+    objects = getObjectsByService(interfaceMap, "test_object_connection_1",
+                                  interfaces);
+    ASSERT_EQ(objects.size(), 1U);
+    EXPECT_EQ(objects[0].first, "/test/object_path_1");
+
+    EXPECT_TRUE(
+        getObjectsByService(interfaceMap, "unknown_connection", interfaces)
+            .empty());
+}
+
+TEST_F(TestHandler, getSubTreeByPattern)
+{
+    std::vector<std::string> interfaces;
+    auto subtree =
+        getSubTreeByPattern(interfaceMap, "/test/object_path_0/child*",
+                            interfaces);
+    ASSERT_EQ(subtree.size(), 2U);
+    EXPECT_EQ(subtree[0].first, "/test/object_path_0/child");
+    EXPECT_EQ(subtree[1].first, "/test/object_path_0/child1");
+    EXPECT_THAT(subtree[1].second["test_object_connection_4"],
+                ElementsAre("test_interface_4"));
+
+    subtree = getSubTreeByPattern(interfaceMap, "/test/object_path_?/*/child1/",
+                                  interfaces);
+    ASSERT_EQ(subtree.size(), 1U);
+    EXPECT_EQ(subtree[0].first, "/test/object_path_0/grandchild/child1");
+
+    // Only paths with as many segments as the pattern match
+    interfaces = {"test_interface_2", "test_interface_3"};
+    subtree = getSubTreeByPattern(interfaceMap, "/test/*/child/*", interfaces);
+    ASSERT_EQ(subtree.size(), 1U);
+    EXPECT_EQ(subtree[0].first, "/test/object_path_0/child/grandchild");
+
+    EXPECT_TRUE(getSubTreeByPattern(interfaceMap, "/test/object_path_0/x*",
+                                    interfaces)
+                    .empty());
+
+    EXPECT_THROW(
+        getSubTreeByPattern(interfaceMap, "test/*", interfaces),
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument);
+    EXPECT_THROW(
+        getSubTreeByPattern(interfaceMap, "/test//child", interfaces),
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument);
+}
+
+TEST_F(TestHandler, getSubTreeCompact)
+{
+    std::string path = "/test/object_path_0/child";
+    std::vector<std::string> interfaces;
+    EXPECT_EQ(tryGetSubTreeCompact(interfaceMap, path, 0, interfaces, 4)
+                  .error(),
+              QueryError::invalidArgument);
+    EXPECT_EQ(tryGetSubTreeCompact(interfaceMap, "/invalid_path", 0,
+                                   interfaces, 0)
+                  .error(),
+              QueryError::resourceNotFound);
+    EXPECT_THROW(
+        getSubTreeCompact(interfaceMap, path, 0, interfaces, 4),
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument);
+
+    interfaceMap.addInterface(interfaceMap.find(path + "/grandchild"),
+                              "test_object_connection_2", "test_interface_9");
+    interfaceMap.addInterface(interfaceMap.find(path + "/grandchild/dog"),
+                              "test_object_connection_2", "test_interface_9");
+    interfaces = {"test_interface_9"};
+
+    auto [names, objects] = getSubTreeCompact(
+        interfaceMap, path, 0, interfaces,
+        static_cast<uint32_t>(SubTreeProjection::paths));
+    EXPECT_TRUE(names.empty());
+    ASSERT_EQ(objects.size(), 2);
+    EXPECT_EQ(std::get<0>(objects[0]), path + "/grandchild");
+    EXPECT_TRUE(std::get<1>(objects[0]).empty());
+    EXPECT_EQ(std::get<0>(objects[1]), path + "/grandchild/dog");
+
+    std::tie(names, objects) = getSubTreeCompact(
+        interfaceMap, path, 0, interfaces,
+        static_cast<uint32_t>(SubTreeProjection::connections));
+    EXPECT_THAT(names, ElementsAre("test_object_connection_2"));
+    ASSERT_EQ(objects.size(), 2);
+    EXPECT_THAT(std::get<1>(objects[0]),
+                ElementsAre(CompactConnection(0, {})));
+    EXPECT_THAT(std::get<1>(objects[1]),
+                ElementsAre(CompactConnection(0, {})));
+
+    std::tie(names, objects) = getSubTreeCompact(
+        interfaceMap, path, 0, interfaces,
+        static_cast<uint32_t>(SubTreeProjection::matchedInterfaces));
+    EXPECT_THAT(names,
+                ElementsAre("test_object_connection_2", "test_interface_9"));
+    ASSERT_EQ(objects.size(), 2);
+    EXPECT_THAT(std::get<1>(objects[0]),
+                ElementsAre(CompactConnection(0, {1})));
+    EXPECT_THAT(std::get<1>(objects[1]),
+                ElementsAre(CompactConnection(0, {1})));
+
+    // Names are shared between paths, and the same as the full result
+    std::tie(names, objects) = getSubTreeCompact(
+        interfaceMap, path, 0, interfaces,
+        static_cast<uint32_t>(SubTreeProjection::interfaces));
+    std::vector<InterfaceMapType::value_type> expanded;
+    for (const auto& [objectPath, connections] : objects)
+    {
+        for (const auto& [connection, connectionInterfaces] : connections)
+        {
+            InterfaceNames interfaceNames;
+            for (uint32_t interface : connectionInterfaces)
+            {
+                interfaceNames.emplace(names[interface]);
+            }
+            addObjectMapResult(expanded, objectPath,
+                               {names[connection], interfaceNames});
+        }
+    }
+    EXPECT_EQ(expanded, getSubTree(interfaceMap, path, 0, interfaces));
+    EXPECT_EQ(names.size(), 3);
+}
+
+// Get every page of a subtree query, checking each is at most pageSize
+static std::vector<std::string> getAllSubTreePathsPages(
+    const InterfaceMapType& interfaceMap, const std::string& path,
+    int32_t depth, std::vector<std::string>& interfaces, uint32_t pageSize)
+{
+    std::vector<std::string> paths;
+    std::string token;
+    do
+    {
+        auto [page, next] = getSubTreePathsPage(interfaceMap, path, depth,
+                                                interfaces, pageSize, token);
+        EXPECT_LE(page.size(), pageSize);
+        paths.insert(paths.end(), page.begin(), page.end());
+        token = std::move(next);
+    } while (!token.empty());
+    return paths;
+}
+
+TEST_F(TestHandler, getSubTreePageBad)
+{
+    std::string path = "/invalid_path";
+    std::vector<std::string> interfaces;
+    EXPECT_THROW(
+        getSubTreePage(interfaceMap, path, 0, interfaces, 2, ""),
+        sdbusplus::xyz::openbmc_project::Common::Error::ResourceNotFound);
+
+    // Tokens from another query
+    path = "/test/object_path_0/child";
+    EXPECT_THROW(
+        getSubTreePage(interfaceMap, path, 0, interfaces, 2,
+                       "/test/object_path_0/child1"),
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument);
+    EXPECT_THROW(
+        getSubTreePathsPage(interfaceMap, path, 1, interfaces, 2,
+                            "/test/object_path_0/child/grandchild/dog"),
+        sdbusplus::xyz::openbmc_project::Common::Error::InvalidArgument);
+
+    // The try functions return the same errors
+    EXPECT_EQ(tryGetSubTreePage(interfaceMap, "/invalid_path", 0, interfaces,
+                                2, "")
+                  .error(),
+              QueryError::resourceNotFound);
+    EXPECT_EQ(tryGetSubTreePathsPage(interfaceMap, path, 0, interfaces, 2,
+                                     "/test/object_path_0/child1")
+                  .error(),
+              QueryError::invalidArgument);
+}
+
+TEST_F(TestHandler, getSubTreePageGood)
+{
+    std::string path = "/test/object_path_0";
+    std::vector<std::string> interfaces;
+
+    auto [page, token] =
+        getSubTreePage(interfaceMap, path, 0, interfaces, 2, "");
+    ASSERT_EQ(page.size(), 2);
+    EXPECT_EQ(page[0].first, "/test/object_path_0/child");
+    EXPECT_EQ(page[1].first, "/test/object_path_0/child/grandchild");
+    EXPECT_THAT(page[1].second["test_object_connection_2"],
+                ElementsAre("test_interface_2"));
+    EXPECT_EQ(token, "/test/object_path_0/child/grandchild");
+
+    std::tie(page, token) =
+        getSubTreePage(interfaceMap, path, 0, interfaces, 0, token);
+    ASSERT_EQ(page.size(), 3);
+    EXPECT_EQ(page[0].first, "/test/object_path_0/child/grandchild/dog");
+    EXPECT_TRUE(token.empty());
+}
+
+TEST_F(TestHandler, getSubTreePathsPageGood)
+{
+    std::vector<std::string> interfaces;
+    for (uint32_t pageSize : {1U, 2U, 3U, 5U, 6U})
+    {
+        EXPECT_EQ(
+            getAllSubTreePathsPages(interfaceMap, "/", 0, interfaces,
+                                    pageSize),
+            getSubTreePaths(interfaceMap, "/", 0, interfaces));
+        EXPECT_EQ(getAllSubTreePathsPages(interfaceMap, "/test/object_path_0",
+                                          2, interfaces, pageSize),
+                  getSubTreePaths(interfaceMap, "/test/object_path_0", 2,
+                                  interfaces));
+    }
+
+    interfaces = {"test_interface_1", "test_interface_3",
+                  "test_interface_5"};
+    EXPECT_THAT(getAllSubTreePathsPages(interfaceMap, "/test/object_path_0",
+                                        0, interfaces, 1),
+                ElementsAre("/test/object_path_0/child",
+                            "/test/object_path_0/child/grandchild/dog",
+                            "/test/object_path_0/grandchild/child1"));
+
+    // Enough interfaces that the tree is walked instead of the index
+    interfaces = {"test_interface_0", "test_interface_1", "test_interface_2",
+                  "test_interface_3", "test_interface_4", "test_interface_5"};
+    EXPECT_EQ(getAllSubTreePathsPages(interfaceMap, "/test/object_path_0", 0,
+                                      interfaces, 2),
+              getSubTreePaths(interfaceMap, "/test/object_path_0", 0,
+                              interfaces));
+}
+
+// Verify a token still works after the path it ended at is removed, and
+// that paths changed before it don't show up again
+TEST_F(TestHandler, getSubTreePathsPageMutation)
+{
+    std::string path = "/test/object_path_0";
+    std::vector<std::string> interfaces;
+
+    auto [page, token] =
+        getSubTreePathsPage(interfaceMap, path, 0, interfaces, 2, "");
+    ASSERT_THAT(page, ElementsAre("/test/object_path_0/child",
+                                  "/test/object_path_0/child/grandchild"));
+
+    interfaceMap.erase(interfaceMap.find(token));
+    interfaceMap.addConnection(
+        interfaceMap.emplace("/test/object_path_0/child/a").first, "conn");
+    interfaceMap.addConnection(
+        interfaceMap.emplace("/test/object_path_0/child/h").first, "conn");
+
+    std::tie(page, token) =
+        getSubTreePathsPage(interfaceMap, path, 0, interfaces, 0, token);
+    EXPECT_THAT(page, ElementsAre("/test/object_path_0/child/grandchild/dog",
+                                  "/test/object_path_0/child/h",
+                                  "/test/object_path_0/child1",
+                                  "/test/object_path_0/grandchild/child1"));
+    EXPECT_TRUE(token.empty());
+}
+
 TEST_F(TestHandler, getAssociatedSubTreeBad)
 {
     sdbusplus::message::object_path path("/test/object_path_0");
@@ -439,6 +758,35 @@ TEST_F(TestHandler, getAssociatedSubTreePathsGood)
                 ElementsAre("/test/object_path_0/child/grandchild"));
 }
 
+TEST_F(TestHandler, getAssociatedSubTreePathsEndpointOrder)
+{
+    sdbusplus::message::object_path path("/test/object_path_0");
+    sdbusplus::message::object_path associatedPath = path / "descendent";
+    auto& association = associationMap.ifaces[associatedPath.str];
+    std::get<endpointsPos>(association) = {
+        "/test/object_path_0/child1",
+        "/test/object_path_0/child/grandchild/dog",
+        // Not below the requested path
+        "/test/object_path_0",
+        // Not on D-Bus
+        "/test/object_path_0/missing",
+        "/test/object_path_0/child",
+    };
+    std::get<endpointLookupPos>(association).clear();
+    std::vector<std::string> interfaces;
+
+    // Results are in path order, whatever the order of the endpoints
+    EXPECT_THAT(getAssociatedSubTreePaths(interfaceMap, associationMap,
+                                          associatedPath, path, 0, interfaces),
+                ElementsAre("/test/object_path_0/child",
+                            "/test/object_path_0/child/grandchild/dog",
+                            "/test/object_path_0/child1"));
+    EXPECT_THAT(getAssociatedSubTreePaths(interfaceMap, associationMap,
+                                          associatedPath, path, 1, interfaces),
+                ElementsAre("/test/object_path_0/child",
+                            "/test/object_path_0/child1"));
+}
+
 TEST_F(TestHandler, getAssociatedSubTreeByIdBad)
 {
     sdbusplus::message::object_path path("/test/object_path_0");
@@ -582,3 +930,136 @@ TEST_F(TestHandler, getAssociatedSubTreePathsByIdGood)
     ASSERT_THAT(subtreePath, ElementsAre("/test/object_path_0/child1",
                                          "/test/object_path_0/child"));
 }
+
+// Verify each batched query gets the result of its method, and a failing
+// one only fails itself
+TEST_F(TestHandler, executeBatch)
+{
+    std::vector<std::string> interfaces = {"test_interface_1"};
+    std::vector<BatchQuery> queries = {
+        {"GetObject",
+         {{"path", "/test/object_path_0/child"}, {"interfaces", interfaces}}},
+        {"GetObject", {{"path", "/test/object_path_0/missing"}}},
+        {"GetSubTreePaths", {{"path", "/test/object_path_0"}, {"depth", 1}}},
+        {"GetSubTree",
+         {{"path", "/test/object_path_0"}, {"interfaces", interfaces}}},
+        {"GetAssociatedSubTreePaths",
+         {{"associationPath", "/test/object_path_0/descendent"},
+          {"path", "/test/object_path_0"}}},
+        {"GetSubTree", {{"path", 0}}},
+        {"GetAncestors", {}},
+        {"SetObject", {{"path", "/test"}}},
+    };
+
+    MissCache missCache(16);
+    std::vector<BatchResult> results =
+        executeBatch(interfaceMap, associationMap, missCache, queries);
+    ASSERT_EQ(results.size(), queries.size());
+
+    for (size_t i : {0U, 2U, 3U, 4U})
+    {
+        EXPECT_EQ(std::get<0>(results[i]), "") << i;
+    }
+    EXPECT_EQ(std::get<1>(results[0]),
+              BatchValue(getObject(interfaceMap, "/test/object_path_0/child",
+                                   interfaces)));
+    EXPECT_EQ(std::get<1>(results[2]),
+              BatchValue(std::vector<std::string>{
+                  "/test/object_path_0/child", "/test/object_path_0/child1"}));
+    EXPECT_EQ(std::get<1>(results[3]),
+              BatchValue(getSubTree(interfaceMap, "/test/object_path_0", 0,
+                                    interfaces)));
+    EXPECT_EQ(std::get<1>(results[4]),
+              BatchValue(std::vector<std::string>{
+                  "/test/object_path_0/child",
+                  "/test/object_path_0/child/grandchild"}));
+
+    EXPECT_EQ(std::get<0>(results[1]),
+              "xyz.openbmc_project.Common.Error.ResourceNotFound");
+    EXPECT_TRUE(missCache.contains("/test/object_path_0/missing"));
+    EXPECT_EQ(missCache.size(), 1);
+    for (size_t i : {5U, 6U, 7U})
+    {
+        EXPECT_EQ(std::get<0>(results[i]),
+                  "xyz.openbmc_project.Common.Error.InvalidArgument")
+            << i;
+    }
+}
+
+TEST(HandlerById, SameOrderAsPerIdQueries)
+{
+    InterfaceMapType interfaceMap = {
+        {"/inv", {{"conn0", {"item"}}}},
+        {"/inv/a/board", {{"conn0", {"board"}}}},
+        {"/inv/b/board", {{"conn0", {"board"}}}},
+        {"/inv/c/board", {{"conn1", {"other"}}}},
+        {"/inv/s1", {{"conn2", {"sensor"}}}},
+        {"/inv/s2", {{"conn2", {"sensor"}}, {"conn3", {"sensor"}}}},
+        {"/inv/s3", {{"conn2", {"other"}}}},
+    };
+    AssociationMaps associationMap = {
+        .ifaces =
+            {
+                {
+                    "/inv/a/board/sensors",
+                    {
+                        std::shared_ptr<sdbusplus::asio::dbus_interface>(),
+                        {"/inv/s2", "/inv/s1", "/inv/s3", "/missing"},
+                        EndpointLookup(),
+                    },
+                },
+                {
+                    // The last endpoint of /inv/a/board again
+                    "/inv/b/board/sensors",
+                    {
+                        std::shared_ptr<sdbusplus::asio::dbus_interface>(),
+                        {"/inv/s2"},
+                        EndpointLookup(),
+                    },
+                },
+                {
+                    // Not on a path with the subtree interface
+                    "/inv/c/board/sensors",
+                    {
+                        std::shared_ptr<sdbusplus::asio::dbus_interface>(),
+                        {"/inv/s1"},
+                        EndpointLookup(),
+                    },
+                },
+            },
+        .owners = {},
+        .pending = {},
+    };
+    std::vector<std::string> subtreeInterfaces = {"board"};
+    std::vector<std::string> endpointInterfaces = {"sensor"};
+
+    // Same as one associated subtree query per matching id path, one after
+    // the other
+    std::vector<InterfaceMapType::value_type> expected;
+    for (const char* idPath : {"/inv/a/board", "/inv/b/board"})
+    {
+        sdbusplus::message::object_path associationPath(
+            std::string(idPath) + "/sensors");
+        auto associated =
+            getAssociatedSubTree(interfaceMap, associationMap, associationPath,
+                                 sdbusplus::message::object_path("/inv"), 0,
+                                 endpointInterfaces);
+        expected.insert(expected.end(), associated.begin(), associated.end());
+    }
+
+    std::vector<InterfaceMapType::value_type> subtree =
+        getAssociatedSubTreeById(interfaceMap, associationMap, "board", "/inv",
+                                 subtreeInterfaces, "sensors",
+                                 endpointInterfaces);
+    EXPECT_EQ(subtree, expected);
+    ASSERT_EQ(subtree.size(), 3);
+    EXPECT_EQ(subtree[0].first, "/inv/s1");
+    EXPECT_EQ(subtree[1].first, "/inv/s2");
+    EXPECT_EQ(subtree[2].first, "/inv/s2");
+    EXPECT_EQ(subtree[2].second.size(), 2);
+
+    EXPECT_THAT(getAssociatedSubTreePathsById(
+                    interfaceMap, associationMap, "board", "/inv",
+                    subtreeInterfaces, "sensors", endpointInterfaces),
+                ElementsAre("/inv/s1", "/inv/s2", "/inv/s2"));
+}
@@ -0,0 +1,574 @@
+#include "src/interface_map.hpp"
+
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+static std::vector<std::string> descendants(
+    const InterfaceMapType& interfaceMap, const std::string& path,
+    int32_t depth = std::numeric_limits<int32_t>::max())
+{
+    std::vector<std::string> paths;
+    const PathNode* node = interfaceMap.findNode(path);
+    if (node != nullptr)
+    {
+        InterfaceMapType::forEachDescendant(
+            *node, depth,
+            [&paths](const auto& entry) { paths.emplace_back(entry.first); });
+    }
+    return paths;
+}
+
+// Verify the tree has a node for every prefix, but only stored paths
+// have an entry
+TEST(InterfaceMap, FindNode)
+{
+    InterfaceMapType interfaceMap = {{"/a/b/c", {{"conn", {"iface"}}}}};
+
+    const PathNode* node = interfaceMap.findNode("/a/b/c");
+    ASSERT_NE(node, nullptr);
+    ASSERT_NE(node->entry, nullptr);
+    EXPECT_EQ(node->entry->first, "/a/b/c");
+
+    node = interfaceMap.findNode("/a");
+    ASSERT_NE(node, nullptr);
+    EXPECT_EQ(node->entry, nullptr);
+
+    EXPECT_EQ(interfaceMap.findNode("/a/b/d"), nullptr);
+    EXPECT_EQ(interfaceMap.findNode("/x"), nullptr);
+}
+
+// Verify the empty path and "/" are distinct nodes
+TEST(InterfaceMap, RootPaths)
+{
+    InterfaceMapType interfaceMap = {{"", {{"conn", {}}}},
+                                     {"/", {{"conn", {"iface"}}}},
+                                     {"/a", {{"conn", {"iface"}}}}};
+
+    const PathNode* root = interfaceMap.findNode("");
+    const PathNode* slash = interfaceMap.findNode("/");
+    ASSERT_NE(root, nullptr);
+    ASSERT_NE(slash, nullptr);
+    EXPECT_NE(root, slash);
+    EXPECT_EQ(root->entry->first, "");
+    EXPECT_EQ(slash->entry->first, "/");
+
+    EXPECT_THAT(descendants(interfaceMap, ""), ElementsAre("/", "/a"));
+    EXPECT_TRUE(descendants(interfaceMap, "/").empty());
+}
+
+// Verify a walk of the tree visits paths in the same order as the map
+TEST(InterfaceMap, DescendantOrder)
+{
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"conn", {"iface"}}}},   {"/a/b/c", {{"conn", {"iface"}}}},
+        {"/a/bc", {{"conn", {"iface"}}}}, {"/a/b", {{"conn", {"iface"}}}},
+        {"/a/d/e", {{"conn", {"iface"}}}}, {"/b", {{"conn", {"iface"}}}},
+        {"/a0", {{"conn", {"iface"}}}}};
+
+    std::vector<std::string> mapOrder;
+    for (const auto& [path, _] : interfaceMap)
+    {
+        mapOrder.emplace_back(path);
+    }
+    EXPECT_THAT(descendants(interfaceMap, ""), ElementsAreArray(mapOrder));
+
+    EXPECT_THAT(descendants(interfaceMap, "/a"),
+                ElementsAre("/a/b", "/a/b/c", "/a/bc", "/a/d/e"));
+}
+
+// Verify the depth limit stops the walk
+TEST(InterfaceMap, DescendantDepth)
+{
+    InterfaceMapType interfaceMap = {{"/a/b", {{"conn", {"iface"}}}},
+                                     {"/a/b/c", {{"conn", {"iface"}}}},
+                                     {"/a/b/c/d", {{"conn", {"iface"}}}},
+                                     {"/a/e/f", {{"conn", {"iface"}}}}};
+
+    EXPECT_THAT(descendants(interfaceMap, "/a", 1), ElementsAre("/a/b"));
+    EXPECT_THAT(descendants(interfaceMap, "/a", 2),
+                ElementsAre("/a/b", "/a/b/c", "/a/e/f"));
+    EXPECT_THAT(descendants(interfaceMap, "/a/b", 1), ElementsAre("/a/b/c"));
+}
+
+// Verify erasing a path prunes the branches nothing else needs
+TEST(InterfaceMap, EraseRemovesNodes)
+{
+    InterfaceMapType interfaceMap = {{"/a/b/c", {{"conn", {"iface"}}}},
+                                     {"/a/d", {{"conn", {"iface"}}}}};
+
+    interfaceMap.erase(interfaceMap.find("/a/b/c"));
+    EXPECT_FALSE(interfaceMap.contains("/a/b/c"));
+    EXPECT_EQ(interfaceMap.findNode("/a/b"), nullptr);
+    EXPECT_NE(interfaceMap.findNode("/a"), nullptr);
+    EXPECT_THAT(descendants(interfaceMap, ""), ElementsAre("/a/d"));
+
+    interfaceMap.erase(interfaceMap.find("/a/d"));
+    EXPECT_TRUE(interfaceMap.empty());
+    EXPECT_EQ(interfaceMap.findNode("/a"), nullptr);
+}
+
+// Verify a connection goes away with its last interface
+TEST(InterfaceMap, RemoveInterface)
+{
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"conn0", {"iface0", "iface1"}}, {"conn1", {"iface0"}}}}};
+    auto path = interfaceMap.find("/a");
+
+    EXPECT_FALSE(interfaceMap.removeInterface(path, "conn0", "iface0"));
+    EXPECT_THAT(toInterfaceNames(*findInterfaces(path->second, "conn0")),
+                ElementsAre("iface1"));
+
+    EXPECT_TRUE(interfaceMap.removeInterface(path, "conn0", "iface1"));
+    EXPECT_EQ(findInterfaces(path->second, "conn0"), nullptr);
+
+    EXPECT_TRUE(interfaceMap.removeConnection(path, "conn1"));
+    EXPECT_FALSE(interfaceMap.removeConnection(path, "conn1"));
+    EXPECT_TRUE(path->second.empty());
+}
+
+static std::vector<std::string> interfacePaths(
+    const InterfaceMapType& interfaceMap, const std::string& interface)
+{
+    std::vector<std::string> paths;
+    const InterfaceMapType::PathSet* index =
+        interfaceMap.findInterface(interface);
+    if (index != nullptr)
+    {
+        for (const PathNode* node : *index)
+        {
+            paths.emplace_back(node->entry->first);
+        }
+    }
+    return paths;
+}
+
+// Verify the interface index follows interfaces being added and removed
+TEST(InterfaceMap, InterfaceIndex)
+{
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"conn0", {"iface0", "iface1"}}, {"conn1", {"iface0"}}}},
+        {"/a/b", {{"conn0", {"iface1"}}}}};
+
+    EXPECT_THAT(interfacePaths(interfaceMap, "iface0"), ElementsAre("/a"));
+    EXPECT_THAT(interfacePaths(interfaceMap, "iface1"),
+                ElementsAre("/a", "/a/b"));
+
+    // Still on conn1
+    auto path = interfaceMap.find("/a");
+    interfaceMap.removeInterface(path, "conn0", "iface0");
+    EXPECT_THAT(interfacePaths(interfaceMap, "iface0"), ElementsAre("/a"));
+
+    interfaceMap.removeConnection(path, "conn1");
+    EXPECT_EQ(interfaceMap.findInterface("iface0"), nullptr);
+
+    interfaceMap.addInterface(interfaceMap.emplace("/c").first, "conn1",
+                              "iface0");
+    EXPECT_THAT(interfacePaths(interfaceMap, "iface0"), ElementsAre("/c"));
+
+    interfaceMap.erase(interfaceMap.find("/a"));
+    EXPECT_THAT(interfacePaths(interfaceMap, "iface1"), ElementsAre("/a/b"));
+}
+
+static std::vector<std::string> connectionPaths(
+    const InterfaceMapType& interfaceMap, const std::string& connection)
+{
+    std::vector<std::string> paths;
+    const InterfaceMapType::PathSet* index =
+        interfaceMap.findConnection(connection);
+    if (index != nullptr)
+    {
+        for (const PathNode* node : *index)
+        {
+            paths.emplace_back(node->entry->first);
+        }
+    }
+    return paths;
+}
+
+// Verify the connection index follows connections being added and removed
+TEST(InterfaceMap, ConnectionIndex)
+{
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"conn0", {"iface0", "iface1"}}, {"conn1", {"iface0"}}}},
+        {"/a/b", {{"conn0", {"iface1"}}}}};
+
+    EXPECT_THAT(connectionPaths(interfaceMap, "conn0"),
+                ElementsAre("/a", "/a/b"));
+    EXPECT_THAT(connectionPaths(interfaceMap, "conn1"), ElementsAre("/a"));
+    EXPECT_EQ(interfaceMap.findConnection("unknown"), nullptr);
+
+    // The connection stays until its last interface on the path is gone
+    auto path = interfaceMap.find("/a");
+    interfaceMap.removeInterface(path, "conn0", "iface0");
+    EXPECT_THAT(connectionPaths(interfaceMap, "conn0"),
+                ElementsAre("/a", "/a/b"));
+    interfaceMap.removeInterface(path, "conn0", "iface1");
+    EXPECT_THAT(connectionPaths(interfaceMap, "conn0"), ElementsAre("/a/b"));
+
+    interfaceMap.removeConnection(path, "conn1");
+    EXPECT_EQ(interfaceMap.findConnection("conn1"), nullptr);
+
+    interfaceMap.addConnection(path, "conn1");
+    interfaceMap.addInterface(interfaceMap.emplace("/c").first, "conn1",
+                              "iface0");
+    EXPECT_THAT(connectionPaths(interfaceMap, "conn1"),
+                ElementsAre("/a", "/c"));
+
+    interfaceMap.erase(path);
+    EXPECT_THAT(connectionPaths(interfaceMap, "conn1"), ElementsAre("/c"));
+}
+
+// Verify removing a connection from all of its paths at once erases the
+// paths that have no other connection, and keeps the indexes up to date
+TEST(InterfaceMap, RemoveConnectionEverywhere)
+{
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"conn0", {"iface0"}}, {"conn1", {"iface1"}}}},
+        {"/a/b", {{"conn1", {"iface1"}}}}};
+    // Enough paths for the index to be a frozen array, some of them below
+    // others that go as well
+    for (size_t i = 0; i < 100; i++)
+    {
+        std::string path = "/a/b/p" + std::to_string(i);
+        interfaceMap.addInterface(interfaceMap.emplace(path).first, "conn1",
+                                  "iface1");
+        interfaceMap.addInterface(interfaceMap.emplace(path + "/q").first,
+                                  "conn1", "iface1");
+    }
+
+    interfaceMap.removeConnection("conn1");
+    interfaceMap.removeConnection("conn1");
+    interfaceMap.removeConnection("unknown");
+
+    EXPECT_EQ(interfaceMap.findConnection("conn1"), nullptr);
+    EXPECT_EQ(interfaceMap.findInterface("iface1"), nullptr);
+    EXPECT_EQ(interfaceMap.size(), 1);
+    EXPECT_THAT(connectionPaths(interfaceMap, "conn0"), ElementsAre("/a"));
+    EXPECT_EQ(interfaceMap.findNode("/a/b"), nullptr);
+    EXPECT_FALSE(interfaceMap.hasConnectionBelow(interfaceMap.find("/a"),
+                                                 "conn1"));
+
+    interfaceMap.addInterface(interfaceMap.emplace("/a/c").first, "conn1",
+                              "iface1");
+    EXPECT_THAT(connectionPaths(interfaceMap, "conn1"), ElementsAre("/a/c"));
+}
+
+// Verify an index big enough to be mostly a frozen array stays in path
+// order, and is searched correctly, as paths come and go
+TEST(InterfaceMap, LargeInterfaceIndex)
+{
+    // Zero padded, so the paths sort in number order
+    auto pathOf = [](size_t i) {
+        std::string number = std::to_string(i);
+        return "/big/p" + std::string(4 - number.size(), '0') + number;
+    };
+
+    // Every other path has the interface, added in scrambled order
+    InterfaceMapType interfaceMap;
+    for (size_t n = 0; n < 1000; n++)
+    {
+        size_t i = n * 7919 % 1000;
+        interfaceMap.addInterface(interfaceMap.emplace(pathOf(i)).first,
+                                  "conn", i % 2 == 0 ? "iface0" : "iface1");
+    }
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < 1000; i += 2)
+    {
+        expected.emplace_back(pathOf(i));
+    }
+    EXPECT_THAT(interfacePaths(interfaceMap, "iface0"),
+                ElementsAreArray(expected));
+
+    // Remove some, and add back a few of those
+    for (size_t i = 0; i < 1000; i += 6)
+    {
+        interfaceMap.erase(interfaceMap.find(pathOf(i)));
+    }
+    for (size_t i = 0; i < 1000; i += 30)
+    {
+        interfaceMap.addInterface(interfaceMap.emplace(pathOf(i)).first,
+                                  "conn", "iface0");
+    }
+    expected.clear();
+    for (size_t i = 0; i < 1000; i += 2)
+    {
+        if (i % 6 != 0 || i % 30 == 0)
+        {
+            expected.emplace_back(pathOf(i));
+        }
+    }
+    EXPECT_THAT(interfacePaths(interfaceMap, "iface0"),
+                ElementsAreArray(expected));
+    EXPECT_EQ(interfaceMap.findInterface("iface0")->size(), expected.size());
+
+    // Pages of the index start after the path asked for, even when that
+    // path was removed
+    const PathNode* node = interfaceMap.findNode("/big");
+    InterfaceFilter filter({"iface0"});
+    std::vector<const PathNode*> page = interfaceMap.findDescendants(
+        *node, "/big", 1, filter, pathOf(5), 3);
+    ASSERT_EQ(page.size(), 3);
+    EXPECT_EQ(page[0]->entry->first, pathOf(8));
+    EXPECT_EQ(page[1]->entry->first, pathOf(10));
+    EXPECT_EQ(page[2]->entry->first, pathOf(14));
+
+    page = interfaceMap.findDescendants(*node, "/big", 1, filter, "", 2);
+    ASSERT_EQ(page.size(), 2);
+    EXPECT_EQ(page[0]->entry->first, pathOf(0));
+    EXPECT_EQ(page[1]->entry->first, pathOf(2));
+}
+
+// Verify the counts of connections below a path follow their descendants
+TEST(InterfaceMap, ConnectionsBelow)
+{
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"conn0", {"iface0"}}}},
+        {"/a/b/c", {{"conn0", {"iface0"}}, {"conn1", {"iface1"}}}},
+        {"/a/b/d", {{"conn1", {"iface1"}}}}};
+    auto a = interfaceMap.find("/a");
+
+    EXPECT_TRUE(interfaceMap.hasConnectionBelow(a, "conn0"));
+    EXPECT_TRUE(interfaceMap.hasConnectionBelow(a, "conn1"));
+    EXPECT_FALSE(interfaceMap.hasConnectionBelow(a, "unknown"));
+    EXPECT_FALSE(interfaceMap.hasConnectionBelow(interfaceMap.find("/a/b/c"),
+                                                 "conn0"));
+
+    auto c = interfaceMap.find("/a/b/c");
+    interfaceMap.removeInterface(c, "conn0", "iface0");
+    EXPECT_FALSE(interfaceMap.hasConnectionBelow(a, "conn0"));
+
+    // Still on /a/b/d
+    interfaceMap.erase(c);
+    EXPECT_TRUE(interfaceMap.hasConnectionBelow(a, "conn1"));
+    interfaceMap.removeConnection(interfaceMap.find("/a/b/d"), "conn1");
+    EXPECT_FALSE(interfaceMap.hasConnectionBelow(a, "conn1"));
+
+    interfaceMap.addInterface(interfaceMap.emplace("/a/e").first, "conn0",
+                              "iface0");
+    EXPECT_TRUE(interfaceMap.hasConnectionBelow(a, "conn0"));
+}
+
+// Verify the filtered walk finds the paths with any of the interfaces
+TEST(InterfaceMap, DescendantsWithInterfaces)
+{
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"conn", {"iface0"}}}},
+        {"/a/b", {{"conn", {"iface0", "iface1"}}}},
+        {"/a/b/c", {{"conn", {"iface1"}}}},
+        {"/a/b/c/d", {{"conn", {"iface2"}}}},
+        {"/a/e", {{"conn", {"iface2"}}}},
+        {"/a/e/f", {{"conn", {"iface2"}}}},
+        {"/a/e/g", {{"conn", {"iface2"}}}}};
+
+    auto walk = [&interfaceMap](const std::string& path, int32_t depth,
+                                const std::vector<std::string>& interfaces) {
+        std::vector<std::string> paths;
+        interfaceMap.forEachDescendant(
+            *interfaceMap.findNode(path), path, depth,
+            InterfaceFilter(interfaces),
+            [&paths](const auto& entry) { paths.emplace_back(entry.first); });
+        return paths;
+    };
+
+    constexpr int32_t all = std::numeric_limits<int32_t>::max();
+    EXPECT_THAT(walk("", all, {"iface0", "iface1"}),
+                ElementsAre("/a", "/a/b", "/a/b/c"));
+    EXPECT_THAT(walk("/a", all, {"iface1", "iface0"}),
+                ElementsAre("/a/b", "/a/b/c"));
+    EXPECT_THAT(walk("/a", 1, {"iface1"}), ElementsAre("/a/b"));
+    EXPECT_TRUE(walk("/a", all, {"iface3"}).empty());
+
+    // iface2 is on more paths than there are below /a/e, so the tree is
+    // walked instead and every path is visited
+    EXPECT_THAT(walk("/a/e", all, {"iface2"}),
+                ElementsAre("/a/e/f", "/a/e/g"));
+}
+
+// Verify names keep their ID and are converted back for replies
+TEST(InterfaceMap, NameTable)
+{
+    NameTable names;
+    NameId a = names.intern("a");
+    NameId b = names.intern("b");
+    EXPECT_NE(a, b);
+    EXPECT_EQ(names.intern("a"), a);
+    EXPECT_EQ(names.find("b"), b);
+    EXPECT_FALSE(names.find("c"));
+    EXPECT_EQ(names[b], "b");
+    EXPECT_EQ(names.size(), 2);
+
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"conn1", {"iface1", "iface0"}}, {"conn0", {"iface2"}}}}};
+    ConnectionNames connections =
+        toConnectionNames(interfaceMap.find("/a")->second);
+    ASSERT_EQ(connections.size(), 2);
+    EXPECT_EQ(connections.begin()->first, "conn0");
+    EXPECT_THAT(connections["conn1"], ElementsAre("iface0", "iface1"));
+}
+
+// Verify a filter of unknown interfaces matches nothing rather than
+// everything
+TEST(InterfaceMap, InterfaceFilter)
+{
+    InterfaceMapType interfaceMap = {{"/a", {{"conn", {"iface0"}}}}};
+    const InterfaceIds& interfaces =
+        *findInterfaces(interfaceMap.find("/a")->second, "conn");
+
+    EXPECT_TRUE(InterfaceFilter({}).matches(interfaces));
+    EXPECT_FALSE(InterfaceFilter({}).intersects(interfaces));
+    EXPECT_TRUE(InterfaceFilter({"unknown", "iface0"}).matches(interfaces));
+
+    InterfaceFilter unknown({"unknown"});
+    EXPECT_FALSE(unknown.empty());
+    EXPECT_FALSE(unknown.matches(interfaces));
+}
+
+// Verify equal interface sets are shared, and changing one path leaves the
+// others alone
+TEST(InterfaceMap, SharedInterfaceSets)
+{
+    InterfaceSetStats before = interfaceSetStats();
+    {
+        InterfaceMapType interfaceMap = {
+            {"/a", {{"conn", {"shared0", "shared1"}}}},
+            {"/b", {{"conn", {"shared1", "shared0"}}}},
+            {"/c", {{"conn", {"shared0", "shared1"}}}}};
+        auto a = interfaceMap.find("/a");
+        auto b = interfaceMap.find("/b");
+        const InterfaceIds* aInterfaces = findInterfaces(a->second, "conn");
+        const InterfaceIds* bInterfaces = findInterfaces(b->second, "conn");
+        EXPECT_EQ(*aInterfaces, *bInterfaces);
+        EXPECT_EQ(aInterfaces->begin(), bInterfaces->begin());
+
+        InterfaceSetStats stats = interfaceSetStats();
+        EXPECT_EQ(stats.references - before.references, 3);
+        EXPECT_EQ(stats.referencedIds - before.referencedIds, 6);
+
+        interfaceMap.addInterface(a, "conn", "shared2");
+        EXPECT_THAT(toInterfaceNames(*aInterfaces),
+                    ElementsAre("shared0", "shared1", "shared2"));
+        EXPECT_THAT(toInterfaceNames(*bInterfaces),
+                    ElementsAre("shared0", "shared1"));
+
+        interfaceMap.removeInterface(a, "conn", "shared2");
+        EXPECT_EQ(*aInterfaces, *bInterfaces);
+    }
+
+    // Sets nothing refers to any more are freed
+    InterfaceSetStats after = interfaceSetStats();
+    EXPECT_EQ(after.sets, before.sets);
+    EXPECT_EQ(after.references, before.references);
+}
+
+// Verify the standard interfaces are kept as bits, but still show up like
+// any other interface
+TEST(InterfaceMap, StandardInterfaces)
+{
+    const std::string peer = "org.freedesktop.DBus.Peer";
+    const std::string properties = "org.freedesktop.DBus.Properties";
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"conn", {"iface0", properties, peer}}}},
+        {"/a/b", {{"conn", {"org.freedesktop.DBus.Introspectable", peer,
+                            properties}}}},
+        {"/a/c", {{"conn", {"iface0"}}}}};
+    auto a = interfaceMap.find("/a");
+    const InterfaceIds& aInterfaces = *findInterfaces(a->second, "conn");
+    EXPECT_EQ(aInterfaces.size(), 3);
+    EXPECT_THAT(aInterfaces.named(), ElementsAre(*nameTable().find("iface0")));
+    EXPECT_TRUE(containsInterface(aInterfaces, peer));
+    EXPECT_FALSE(containsInterface(aInterfaces,
+                                   "org.freedesktop.DBus.Introspectable"));
+    EXPECT_FALSE(aInterfaces.onlyStandard());
+    EXPECT_THAT(toInterfaceNames(aInterfaces),
+                ElementsAre("iface0", peer, properties));
+
+    const InterfaceIds& bInterfaces =
+        *findInterfaces(interfaceMap.find("/a/b")->second, "conn");
+    EXPECT_TRUE(bInterfaces.onlyStandard());
+    EXPECT_TRUE(bInterfaces.named().empty());
+
+    // They aren't indexed, but filters still match them
+    EXPECT_EQ(interfaceMap.findInterface(peer), nullptr);
+    auto found = [&interfaceMap](const std::vector<std::string>& interfaces) {
+        std::vector<std::string> paths;
+        for (const PathNode* node : interfaceMap.findDescendants(
+                 *interfaceMap.findNode(""), "", 10,
+                 InterfaceFilter(interfaces), "", 10))
+        {
+            paths.emplace_back(node->entry->first);
+        }
+        return paths;
+    };
+    EXPECT_THAT(found({peer}), ElementsAre("/a", "/a/b"));
+    EXPECT_THAT(found({"org.freedesktop.DBus.Introspectable"}),
+                ElementsAre("/a/b"));
+    EXPECT_THAT(found({"iface0", "org.freedesktop.DBus.Introspectable"}),
+                ElementsAre("/a", "/a/b", "/a/c"));
+
+    interfaceMap.removeInterface(a, "conn", "iface0");
+    interfaceMap.addInterface(a, "conn", "org.freedesktop.DBus.Introspectable");
+    EXPECT_EQ(*findInterfaces(a->second, "conn"), bInterfaces);
+    interfaceMap.removeInterface(a, "conn", peer);
+    EXPECT_THAT(toInterfaceNames(*findInterfaces(a->second, "conn")),
+                ElementsAre("org.freedesktop.DBus.Introspectable", properties));
+}
+
+// Verify ancestors are found by path segment, not by string prefix
+TEST(InterfaceMap, Ancestors)
+{
+    InterfaceMapType interfaceMap = {{"", {{"conn", {}}}},
+                                     {"/", {{"conn", {}}}},
+                                     {"/a", {{"conn", {"iface"}}}},
+                                     {"/a/b", {{"conn", {"iface"}}}},
+                                     {"/a/b/c/d", {{"conn", {"iface"}}}},
+                                     {"/a/bc", {{"conn", {"iface"}}}}};
+
+    auto ancestors = [&interfaceMap](std::string_view path) {
+        std::vector<std::string> paths;
+        for (const PathNode* node : interfaceMap.findAncestors(path))
+        {
+            paths.emplace_back(node->entry->first);
+        }
+        return paths;
+    };
+
+    EXPECT_THAT(ancestors("/a/b/c/d"), ElementsAre("", "/", "/a", "/a/b"));
+    EXPECT_THAT(ancestors("/a/bc"), ElementsAre("", "/", "/a"));
+    EXPECT_THAT(ancestors("/a"), ElementsAre("", "/"));
+    EXPECT_THAT(ancestors("/"), ElementsAre(""));
+    EXPECT_TRUE(ancestors("").empty());
+}
+
+// Verify the leaf index finds paths by their last segment
+TEST(InterfaceMap, LeafIndex)
+{
+    InterfaceMapType interfaceMap = {{"/b/id", {{"conn", {"iface"}}}},
+                                     {"/a/id", {{"conn", {"iface"}}}},
+                                     {"/a/id/c", {{"conn", {"iface"}}}},
+                                     {"/a/idx", {{"conn", {"iface"}}}},
+                                     {"/id", {{"conn", {"iface"}}}}};
+
+    auto leaves = [&interfaceMap](std::string_view leaf) {
+        std::vector<std::string> paths;
+        for (const PathNode* node : interfaceMap.findLeaf(leaf))
+        {
+            paths.emplace_back(node->entry->first);
+        }
+        return paths;
+    };
+
+    EXPECT_THAT(leaves("id"), ElementsAre("/a/id", "/b/id", "/id"));
+    EXPECT_THAT(leaves("c"), ElementsAre("/a/id/c"));
+    EXPECT_TRUE(leaves("a").empty());
+
+    interfaceMap.erase(interfaceMap.find("/b/id"));
+    EXPECT_THAT(leaves("id"), ElementsAre("/a/id", "/id"));
+}
@@ -33,14 +33,18 @@ TEST_F(TestInterfacesAdded, InterfacesAddedGoodPath)
 {
     auto interfaceMap = createDefaultInterfaceMap();
     AssociationMaps assocMaps;
+    MissCache missCache(missCacheEntries);
+    missCache.insert("/logging/entry");
+    missCache.insert("/logging");
+    missCache.insert("/logging/entry/2");
 
     auto intfAdded =
         createInterfacesAdded(assocDefsInterface, assocDefsProperty);
 
     boost::asio::io_context io;
 
-    processInterfaceAdded(io, interfaceMap, defaultSourcePath, intfAdded,
-                          defaultDbusSvc, assocMaps, *server);
+    processInterfaceAdded(io, interfaceMap, missCache, defaultSourcePath,
+                          intfAdded, defaultDbusSvc, assocMaps, *server);
 
     io.run();
 
@@ -49,6 +53,12 @@ TEST_F(TestInterfacesAdded, InterfacesAddedGoodPath)
     // dumpInterfaceMapType(interfaceMap);
     EXPECT_EQ(interfaceMap.size(), 5);
 
+    // The new parent paths are no longer misses
+    EXPECT_FALSE(missCache.contains("/logging/entry"));
+    EXPECT_FALSE(missCache.contains("/logging"));
+    EXPECT_TRUE(missCache.contains("/logging/entry/2"));
+    EXPECT_EQ(missCache.stats().invalidations, 2);
+
     // New association owner created so ensure it now contains a single entry
     // dumpAssociationOwnersType(assocOwners);
     EXPECT_EQ(assocMaps.owners.size(), 1);
@@ -60,3 +70,40 @@ TEST_F(TestInterfacesAdded, InterfacesAddedGoodPath)
     // No pending associations
     EXPECT_EQ(assocMaps.pending.size(), 0);
 }
+
+// Verify parents with just the default interfaces go with the last child
+// of their owner
+TEST_F(TestInterfacesAdded, RemoveUnneededParents)
+{
+    InterfaceMapType interfaceMap;
+    for (const char* path : {"/a", "/a/b"})
+    {
+        for (const char* interface :
+             {"org.freedesktop.DBus.Introspectable",
+              "org.freedesktop.DBus.Peer", "org.freedesktop.DBus.Properties"})
+        {
+            interfaceMap.addInterface(interfaceMap.emplace(path).first,
+                                      defaultDbusSvc, interface);
+        }
+    }
+    interfaceMap.addInterface(interfaceMap.emplace("/a").first, "other", "a");
+    interfaceMap.addInterface(interfaceMap.emplace("/a/b/c").first,
+                              defaultDbusSvc, "a");
+    interfaceMap.addInterface(interfaceMap.emplace("/a/b/d").first,
+                              defaultDbusSvc, "a");
+
+    // /a/b/d is still there
+    interfaceMap.erase(interfaceMap.find("/a/b/c"));
+    removeUnneededParents("/a/b/c", defaultDbusSvc, interfaceMap);
+    EXPECT_NE(interfaceMap.find("/a/b"), interfaceMap.end());
+
+    interfaceMap.erase(interfaceMap.find("/a/b/d"));
+    removeUnneededParents("/a/b/d", defaultDbusSvc, interfaceMap);
+    EXPECT_EQ(interfaceMap.find("/a/b"), interfaceMap.end());
+
+    // The other owner keeps /a
+    auto a = interfaceMap.find("/a");
+    ASSERT_NE(a, interfaceMap.end());
+    EXPECT_EQ(findInterfaces(a->second, defaultDbusSvc), nullptr);
+    EXPECT_NE(findInterfaces(a->second, "other"), nullptr);
+}
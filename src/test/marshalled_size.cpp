@@ -0,0 +1,28 @@
+#include "src/marshalled_size.hpp"
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// Verify strings and arrays are aligned and sized as D-Bus marshals them
+TEST(MarshalledSize, Arrays)
+{
+    EXPECT_EQ(marshalledSize(std::string("ab")), 7);
+    EXPECT_EQ(marshalledSize(std::vector<std::string>{}), 4);
+    EXPECT_EQ(marshalledSize(std::vector<std::string>{"ab", "c"}), 18);
+    EXPECT_EQ(marshalledSize(std::vector<uint64_t>{1}), 16);
+}
+
+// Verify structs and dict entries start on 8 byte boundaries, even in an
+// empty array
+TEST(MarshalledSize, Structs)
+{
+    using Connections = std::vector<std::pair<std::string, std::string>>;
+    EXPECT_EQ(marshalledSize(Connections{}), 8);
+    EXPECT_EQ(marshalledSize(Connections{{"/a", "x"}, {"/b", "y"}}), 38);
+    EXPECT_EQ(marshalledSize(std::tuple<uint32_t, std::string>{1, "a"}), 10);
+}
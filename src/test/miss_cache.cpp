@@ -0,0 +1,47 @@
+#include "src/miss_cache.hpp"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+TEST(MissCache, HitUntilAdded)
+{
+    MissCache cache(missCacheEntries);
+    EXPECT_FALSE(cache.contains("/test/a"));
+
+    cache.insert("/test/a");
+    EXPECT_TRUE(cache.contains("/test/a"));
+    EXPECT_TRUE(cache.contains(std::string("/test/a")));
+    EXPECT_FALSE(cache.contains("/test"));
+    EXPECT_EQ(cache.stats().hits, 2);
+
+    // Adding another path leaves the miss alone
+    cache.erase("/test/b");
+    EXPECT_TRUE(cache.contains("/test/a"));
+    EXPECT_EQ(cache.stats().invalidations, 0);
+
+    cache.erase("/test/a");
+    EXPECT_FALSE(cache.contains("/test/a"));
+    EXPECT_EQ(cache.stats().invalidations, 1);
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(MissCache, ClearedWhenFull)
+{
+    MissCache cache(2);
+    cache.insert("/test/a");
+    cache.insert("/test/b");
+    cache.insert("/test/b");
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.stats().evictions, 0);
+
+    cache.insert("/test/c");
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.stats().evictions, 2);
+    EXPECT_FALSE(cache.contains("/test/a"));
+    EXPECT_TRUE(cache.contains("/test/c"));
+
+    MissCache disabled(0);
+    disabled.insert("/test/a");
+    EXPECT_FALSE(disabled.contains("/test/a"));
+}
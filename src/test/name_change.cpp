@@ -1,9 +1,47 @@
+#include "src/bulk_load.hpp"
 #include "src/processing.hpp"
 #include "src/test/util/asio_server_class.hpp"
 #include "src/test/util/association_objects.hpp"
 
+#include <malloc.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+// The bytes allocated with operator new and not freed yet.  Counting them
+// is exact, unlike the resident size, which depends on the allocator and
+// is different under sanitizers and valgrind.
+static std::atomic<size_t> liveBytes;
+
+void* operator new(size_t size)
+{
+    void* memory = std::malloc(size);
+    if (memory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    liveBytes.fetch_add(malloc_usable_size(memory), std::memory_order_relaxed);
+    return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+    liveBytes.fetch_sub(malloc_usable_size(memory), std::memory_order_relaxed);
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    operator delete(memory);
+}
+
 class TestNameChange : public AsioServerClassTest
 {
   public:
@@ -31,6 +69,27 @@ TEST_F(TestNameChange, UniqueNameNoInterfaces)
     EXPECT_EQ(nameOwners.size(), 0);
 }
 
+// Verify only the paths of the removed service change
+TEST_F(TestNameChange, OnlyOwnedPathsChanged)
+{
+    boost::container::flat_map<std::string, std::string> nameOwners;
+    AssociationMaps assocMaps;
+    InterfaceMapType interfaceMap = {
+        {"/a", {{"svc0", {"iface0"}}}},
+        {"/a/b", {{"svc0", {"iface0"}}, {"svc1", {"iface1"}}}},
+        {"/c", {{"svc1", {"iface1"}}}}};
+
+    processNameChangeDelete(io, nameOwners, "svc0", "svc0", interfaceMap,
+                            assocMaps, *server);
+
+    EXPECT_EQ(interfaceMap.find("/a"), interfaceMap.end());
+    ASSERT_NE(interfaceMap.find("/a/b"), interfaceMap.end());
+    EXPECT_EQ(interfaceMap.find("/a/b")->second.size(), 1);
+    EXPECT_NE(interfaceMap.find("/c"), interfaceMap.end());
+    EXPECT_EQ(interfaceMap.findConnection("svc0"), nullptr);
+    EXPECT_EQ(interfaceMap.findConnection("svc1")->size(), 2);
+}
+
 // Verify path removed from interface map and association objects
 TEST_F(TestNameChange, UniqueNameAssociationsAndInterface)
 {
@@ -64,3 +123,62 @@ TEST_F(TestNameChange, UniqueNameAssociationsAndInterface)
     // Verify interface map was deleted
     EXPECT_TRUE(interfaceMap.empty());
 }
+
+// Verify a service that keeps coming and going, with new paths each time,
+// while another one stays on the bus and changes a little in between,
+// doesn't make the mapper grow
+TEST_F(TestNameChange, ChurnKeepsHeapStable)
+{
+    boost::container::flat_map<std::string, std::string> nameOwners;
+    AssociationMaps assocMaps;
+    InterfaceMapType interfaceMap;
+    const std::string sensors = "/xyz/openbmc_project/sensors/";
+    const std::vector<std::string_view> interfaces = {
+        "org.freedesktop.DBus.Introspectable", "org.freedesktop.DBus.Peer",
+        "org.freedesktop.DBus.Properties", "xyz.openbmc_project.Sensor.Value"};
+
+    BulkLoad stable("stable.svc");
+    for (size_t i = 0; i < 1000; i++)
+    {
+        stable.add(sensors + "stable/sensor" + std::to_string(i), interfaces);
+    }
+    stable.commit(interfaceMap);
+
+    auto hotPlug = [&](size_t round) {
+        BulkLoad scan("churn.svc");
+        for (size_t i = 0; i < 500; i++)
+        {
+            scan.add(sensors + "temperature/hotplug" + std::to_string(round) +
+                         "_" + std::to_string(i),
+                     interfaces);
+        }
+        scan.commit(interfaceMap);
+
+        auto extra = interfaceMap.emplace(sensors + "stable/extra" +
+                                          std::to_string(round % 16));
+        interfaceMap.addInterface(extra.first, "stable.svc",
+                                  "xyz.openbmc_project.Sensor.Value");
+
+        processNameChangeDelete(io, nameOwners, "churn.svc", "churn.svc",
+                                interfaceMap, assocMaps, *server);
+    };
+
+    // The indexes and interned names reach their size in the first rounds
+    size_t round = 0;
+    for (; round < 50; round++)
+    {
+        hotPlug(round);
+    }
+    size_t warm = liveBytes;
+    for (; round < 200; round++)
+    {
+        hotPlug(round);
+    }
+
+    size_t end = liveBytes;
+
+    EXPECT_EQ(interfaceMap.size(), 1016);
+    EXPECT_EQ(interfaceMap.findConnection("churn.svc"), nullptr);
+    // Less than one small allocation a round
+    EXPECT_LT(end, warm + 4096);
+}
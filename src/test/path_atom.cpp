@@ -0,0 +1,63 @@
+#include "src/path_atom.hpp"
+
+#include <boost/container/flat_map.hpp>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// Verify equal paths share one copy, which is freed with the last handle
+TEST(PathAtom, Shared)
+{
+    PathAtomStats before = pathAtomStats();
+    {
+        std::string text = "/test/shared";
+        PathAtom a(text);
+        PathAtom b = a;
+        PathAtom c("/test/shared");
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(a, c);
+        EXPECT_EQ(&a.str(), &c.str());
+        EXPECT_EQ(PathAtom::lookup(text), a);
+
+        PathAtomStats stats = pathAtomStats();
+        EXPECT_EQ(stats.paths - before.paths, 1);
+        EXPECT_EQ(stats.references - before.references, 3);
+
+        // Looking up a path doesn't store it
+        EXPECT_TRUE(PathAtom::lookup("/test/other").empty());
+        EXPECT_EQ(pathAtomStats().paths, stats.paths);
+    }
+    EXPECT_EQ(pathAtomStats().paths, before.paths);
+
+    PathAtom empty("");
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty, PathAtom());
+    EXPECT_EQ(empty.str(), "");
+}
+
+// Verify paths order like their text, so maps keyed by them can be
+// searched with a string
+TEST(PathAtom, Order)
+{
+    PathAtom a("/test/a");
+    PathAtom b("/test/a/b");
+    PathAtom c("/test/c");
+    EXPECT_LT(a, b);
+    EXPECT_LT(b, c);
+    EXPECT_EQ(a, "/test/a");
+    EXPECT_EQ(std::string("/test/c"), c);
+    EXPECT_GT(c, std::string("/test/b"));
+
+    boost::container::flat_map<PathAtom, int, std::less<>> map;
+    map[c] = 2;
+    map["/test/a"] = 0;
+    map[std::string("/test/a/b")] = 1;
+    EXPECT_EQ(map.begin()->first, a);
+    EXPECT_EQ(map.find(std::string("/test/a/b"))->second, 1);
+    EXPECT_EQ(map.find("/test/b"), map.end());
+
+    const std::string& text = c;
+    EXPECT_EQ(text, "/test/c");
+}
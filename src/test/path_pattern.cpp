@@ -0,0 +1,54 @@
+#include "src/path_pattern.hpp"
+
+#include <gtest/gtest.h>
+
+TEST(PathPattern, Compile)
+{
+    auto pattern = PathPattern::compile("/xyz/chassis*/dimm?/");
+    ASSERT_TRUE(pattern);
+    const auto& segments = pattern->segments();
+    ASSERT_EQ(segments.size(), 3U);
+    EXPECT_TRUE(segments[0].literal());
+    EXPECT_EQ(segments[0].glob, "xyz");
+    EXPECT_FALSE(segments[1].literal());
+    EXPECT_EQ(segments[1].prefix(), "chassis");
+    EXPECT_EQ(segments[2].glob, "dimm?");
+
+    pattern = PathPattern::compile("/");
+    ASSERT_TRUE(pattern);
+    ASSERT_EQ(pattern->segments().size(), 1U);
+    EXPECT_EQ(pattern->segments()[0].glob, "");
+
+    EXPECT_EQ(PathPattern::compile("").error(), QueryError::invalidArgument);
+    EXPECT_EQ(PathPattern::compile("xyz/*").error(),
+              QueryError::invalidArgument);
+    EXPECT_EQ(PathPattern::compile("/xyz//dimm*").error(),
+              QueryError::invalidArgument);
+}
+
+TEST(PathPattern, Matches)
+{
+    auto pattern = PathPattern::compile("/a*b/c?d/*x*y/*/e");
+    ASSERT_TRUE(pattern);
+    const auto& segments = pattern->segments();
+
+    EXPECT_TRUE(segments[0].matches("ab"));
+    EXPECT_TRUE(segments[0].matches("a_b_b"));
+    EXPECT_FALSE(segments[0].matches("a_bc"));
+    EXPECT_FALSE(segments[0].matches("ba"));
+
+    EXPECT_TRUE(segments[1].matches("c_d"));
+    EXPECT_FALSE(segments[1].matches("cd"));
+    EXPECT_FALSE(segments[1].matches("c__d"));
+
+    EXPECT_TRUE(segments[2].matches("xy"));
+    EXPECT_TRUE(segments[2].matches("0x1x2y"));
+    EXPECT_FALSE(segments[2].matches("yx"));
+
+    // A glob doesn't match the empty segment of "/"
+    EXPECT_TRUE(segments[3].matches("anything"));
+    EXPECT_FALSE(segments[3].matches(""));
+
+    EXPECT_TRUE(segments[4].matches("e"));
+    EXPECT_FALSE(segments[4].matches("ee"));
+}
@@ -0,0 +1,186 @@
+#include "src/handler.hpp"
+#include "src/query_cache.hpp"
+
+#include <xyz/openbmc_project/Common/error.hpp>
+
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+using ::testing::ElementsAre;
+
+class QueryCacheTest : public testing::Test
+{
+  protected:
+    QueryCacheTest()
+    {
+        interfaceMap = {
+            {"/test", {{"conn", {"iface"}}}},
+            {"/test/a", {{"conn", {"iface", "other"}}}},
+            {"/test/a/b", {{"conn", {"iface"}}}},
+            {"/test/c", {{"conn", {"other"}}}},
+        };
+    }
+
+    using PathsCache = QueryCache<std::vector<std::string>>;
+
+    std::vector<std::string> getSubTreePaths(PathsCache& cache,
+                                             const std::string& path,
+                                             int32_t depth = 0)
+    {
+        return valueOrThrow(cache.get(
+            makeQueryKey("GetSubTreePaths", path, depth, interfaces),
+            interfaceMap, [&]() {
+                return tryGetSubTreePaths(interfaceMap, path, depth,
+                                          interfaces);
+            }));
+    }
+
+    InterfaceMapType interfaceMap;
+    std::vector<std::string> interfaces;
+};
+
+// Verify a repeated query is answered from the cache
+TEST_F(QueryCacheTest, HitAfterMiss)
+{
+    PathsCache cache(queryCacheEntries);
+
+    std::vector<std::string> first = getSubTreePaths(cache, "/test");
+    EXPECT_EQ(cache.stats().misses, 1);
+    EXPECT_EQ(cache.stats().hits, 0);
+
+    std::vector<std::string> second = getSubTreePaths(cache, "/test");
+    EXPECT_EQ(cache.stats().misses, 1);
+    EXPECT_EQ(cache.stats().hits, 1);
+    EXPECT_EQ(first, second);
+    EXPECT_THAT(second, ElementsAre("/test/a", "/test/a/b", "/test/c"));
+
+    // Another method has its own entry
+    cache.get(makeQueryKey("GetSubTree", "/test", 0, interfaces), interfaceMap,
+              [&]() { return QueryResult<std::vector<std::string>>(second); });
+    EXPECT_EQ(cache.stats().misses, 2);
+    EXPECT_EQ(cache.size(), 2);
+}
+
+// Verify requests that only differ in form share an entry
+TEST_F(QueryCacheTest, EquivalentKeys)
+{
+    PathsCache cache(queryCacheEntries);
+
+    interfaces = {"other", "iface"};
+    getSubTreePaths(cache, "/test");
+
+    interfaces = {"iface", "other", "iface"};
+    getSubTreePaths(cache, "/test/", -1);
+    EXPECT_EQ(cache.stats().hits, 1);
+    EXPECT_EQ(cache.size(), 1);
+
+    getSubTreePaths(cache, "/test", 1);
+    EXPECT_EQ(cache.stats().misses, 2);
+}
+
+// Verify a change below the requested path gives a fresh result, but a
+// change elsewhere doesn't drop the entry
+TEST_F(QueryCacheTest, Invalidation)
+{
+    PathsCache cache(queryCacheEntries);
+
+    interfaces = {"other"};
+    EXPECT_THAT(getSubTreePaths(cache, "/test/a"), ElementsAre());
+
+    interfaceMap.addInterface(interfaceMap.find("/test/c"), "conn", "new");
+    interfaceMap.emplace("/elsewhere");
+    EXPECT_THAT(getSubTreePaths(cache, "/test/a"), ElementsAre());
+    EXPECT_EQ(cache.stats().hits, 1);
+
+    interfaceMap.addInterface(interfaceMap.find("/test/a/b"), "conn", "other");
+    EXPECT_THAT(getSubTreePaths(cache, "/test/a"), ElementsAre("/test/a/b"));
+    EXPECT_EQ(cache.stats().hits, 1);
+    EXPECT_EQ(cache.stats().misses, 2);
+
+    interfaceMap.removeConnection(interfaceMap.find("/test/a/b"), "conn");
+    interfaceMap.erase(interfaceMap.find("/test/a/b"));
+    EXPECT_THAT(getSubTreePaths(cache, "/test/a"), ElementsAre());
+    EXPECT_EQ(cache.stats().misses, 3);
+    EXPECT_EQ(cache.size(), 1);
+}
+
+// Verify a cached path that has gone away is reported as missing
+TEST_F(QueryCacheTest, RemovedPath)
+{
+    PathsCache cache(queryCacheEntries);
+
+    getSubTreePaths(cache, "/test/a/b");
+    interfaceMap.erase(interfaceMap.find("/test/a/b"));
+
+    EXPECT_THROW(
+        getSubTreePaths(cache, "/test/a/b"),
+        sdbusplus::xyz::openbmc_project::Common::Error::ResourceNotFound);
+    EXPECT_EQ(cache.size(), 0);
+}
+
+// Verify the least recently used entry is the one dropped
+TEST_F(QueryCacheTest, Eviction)
+{
+    PathsCache cache(2);
+
+    getSubTreePaths(cache, "/test");
+    getSubTreePaths(cache, "/test/a");
+    getSubTreePaths(cache, "/test");
+    getSubTreePaths(cache, "/test/c");
+    EXPECT_EQ(cache.stats().evictions, 1);
+    EXPECT_EQ(cache.size(), 2);
+
+    getSubTreePaths(cache, "/test");
+    EXPECT_EQ(cache.stats().hits, 2);
+
+    getSubTreePaths(cache, "/test/a");
+    EXPECT_EQ(cache.stats().misses, 4);
+    EXPECT_EQ(cache.stats().evictions, 2);
+}
+
+// Verify the total size of the values bounds the cache, and values that
+// are too large aren't kept at all
+TEST_F(QueryCacheTest, ByteBudget)
+{
+    struct PathsSize
+    {
+        size_t operator()(const std::vector<std::string>& paths) const
+        {
+            return paths.size();
+        }
+    };
+    QueryCache<std::vector<std::string>, PathsSize> cache(queryCacheEntries,
+                                                          4, 2);
+    auto getPaths = [&](const std::string& path) {
+        return valueOrThrow(cache.get(
+            makeQueryKey("GetSubTreePaths", path, 0, interfaces),
+            interfaceMap, [&]() {
+                return tryGetSubTreePaths(interfaceMap, path, 0, interfaces);
+            }));
+    };
+
+    // 3 paths is more than one value may take
+    EXPECT_THAT(getPaths("/test"),
+                ElementsAre("/test/a", "/test/a/b", "/test/c"));
+    EXPECT_EQ(cache.stats().uncached, 1);
+    EXPECT_EQ(cache.size(), 0);
+
+    getPaths("/test/a");
+    getPaths("/test/a/b");
+    EXPECT_EQ(cache.valueBytes(), 1);
+
+    interfaces = {"iface"};
+    getPaths("/test");
+    EXPECT_EQ(cache.valueBytes(), 3);
+    EXPECT_EQ(cache.stats().evictions, 0);
+
+    // The least recently used value goes to make room
+    interfaces = {"other"};
+    getPaths("/test");
+    EXPECT_EQ(cache.stats().evictions, 1);
+    EXPECT_EQ(cache.valueBytes(), 4);
+    EXPECT_EQ(cache.size(), 3);
+}
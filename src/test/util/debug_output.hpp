@@ -58,7 +58,7 @@ inline void dumpInterfaceMapType(InterfaceMapType& intfMap)
         cout << "------------------------------------\n";
         cout << setw(15) << left << "OBJ PATH:" << i.first << '\n';
 
-        for (const auto& j : i.second)
+        for (const auto& j : toConnectionNames(i.second))
         {
             cout << setw(16) << left << "DBUS SERVICE:" << j.first << '\n';
 
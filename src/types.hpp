@@ -1,20 +1,25 @@
 #pragma once
 
+#include "path_atom.hpp"
+
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
 #include <sdbusplus/asio/object_server.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <expected>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <tuple>
 #include <vector>
 
-/** @brief interface_map_type is the underlying datastructure the mapper uses.
+/** @brief The connections and interfaces on a single object path.
  *
- * The 3 levels of map are
- * object paths
- *   connection names
- *      interface names
+ * The 2 levels of map are
+ * connection names
+ *    interface names
  */
 using InterfaceNames = boost::container::flat_set<std::string, std::less<>,
                                                   std::vector<std::string>>;
@@ -23,24 +28,74 @@ using ConnectionNames = boost::container::flat_map<
     std::string, InterfaceNames, std::less<>,
     std::vector<std::pair<std::string, InterfaceNames>>>;
 
-using InterfaceMapType = boost::container::flat_map<
-    std::string, ConnectionNames, std::less<>,
-    std::vector<std::pair<std::string, ConnectionNames>>>;
+/** @brief Why a mapper query has no result */
+enum class QueryError
+{
+    resourceNotFound,
+    invalidArgument,
+};
+
+/** @brief The result of a mapper query, or why there isn't one.
+ *
+ * Misses are common, for example while clients wait for services to
+ * start, so queries return them instead of throwing.
+ */
+template <typename T>
+using QueryResult = std::expected<T, QueryError>;
 
 /**
  *  Associations and some metadata are stored in associationInterfaces.
  *  The fields are:
  *   * ifacePos - holds the D-Bus interface object
  *   * endpointsPos - holds the endpoints array that shadows the property
+ *   * endpointLookupPos - holds the endpoints in path order for queries
  */
 static constexpr auto ifacePos = 0;
 static constexpr auto endpointsPos = 1;
-using Endpoints = std::vector<std::string>;
+static constexpr auto endpointLookupPos = 2;
+using Endpoints = std::vector<PathAtom>;
+
+/**
+ * The order of an association's endpoints by path, so queries can look
+ * them up in the interface map in the order results are returned in.  It
+ * is worked out by the first query that needs it, and has to be cleared
+ * whenever the endpoints change.
+ */
+class EndpointLookup
+{
+  public:
+    /** @brief Get the indexes of the endpoints in path order */
+    const std::vector<uint32_t>& sorted(const Endpoints& endpoints) const
+    {
+        if (order.size() != endpoints.size())
+        {
+            order.resize(endpoints.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::sort(order.begin(), order.end(),
+                      [&endpoints](uint32_t lhs, uint32_t rhs) {
+                          return endpoints[lhs] < endpoints[rhs];
+                      });
+        }
+        return order;
+    }
+
+    /** @brief Forget the order after the endpoints changed */
+    void clear()
+    {
+        order.clear();
+    }
 
-// map[interface path: tuple[dbus_interface,vector[endpoint paths]]]
+  private:
+    mutable std::vector<uint32_t> order;
+};
+
+// map[interface path:
+//     tuple[dbus_interface,vector[endpoint paths],endpoint lookup]]
 using AssociationInterfaces = boost::container::flat_map<
-    std::string,
-    std::tuple<std::shared_ptr<sdbusplus::asio::dbus_interface>, Endpoints>>;
+    PathAtom,
+    std::tuple<std::shared_ptr<sdbusplus::asio::dbus_interface>, Endpoints,
+               EndpointLookup>,
+    std::less<>>;
 
 /**
  * The associationOwners map contains information about creators of
@@ -57,12 +112,14 @@ using AssociationInterfaces = boost::container::flat_map<
  *     [/logging/entry/1/callout : [/system/cpu0],
  *      /system/cpu0/fault : [/logging/entry/1]]]]
  */
+using EndpointSet = boost::container::flat_set<PathAtom, std::less<>>;
+
 using AssociationPaths =
-    boost::container::flat_map<std::string,
-                               boost::container::flat_set<std::string>>;
+    boost::container::flat_map<PathAtom, EndpointSet, std::less<>>;
 
 using AssociationOwnersType = boost::container::flat_map<
-    std::string, boost::container::flat_map<std::string, AssociationPaths>>;
+    PathAtom, boost::container::flat_map<std::string, AssociationPaths>,
+    std::less<>>;
 
 /**
  * Store the contents of the associations property on the interface
@@ -87,7 +144,8 @@ constexpr auto ownerPos = 0;
 constexpr auto assocPos = 1;
 using ExistingEndpoint = std::tuple<std::string, Association>;
 using ExistingEndpoints = std::vector<ExistingEndpoint>;
-using PendingAssociations = std::map<std::string, ExistingEndpoints>;
+using PendingAssociations =
+    std::map<PathAtom, ExistingEndpoints, std::less<>>;
 
 /**
  *  The return type of findAssociations().